@@ -1,6 +1,6 @@
 import QtQuick 2.0
 import QtCharts 2.2
-import Util 1.0
+import ChartProfileSink 1.0
 
 Item {
     id: root
@@ -9,6 +9,16 @@ Item {
 
     property real maxDepthToDraw: 0
     property real minDepthToDraw: 0
+    // Connect it to a sensor with addProfileSink
+    property alias profileSink: profileSink
+
+    ChartProfileSink {
+        id: profileSink
+        series: serie
+        inverseSeries: serieInv
+        minDepthToDraw: root.minDepthToDraw
+        maxDepthToDraw: root.maxDepthToDraw
+    }
 
     function correctChartSize() {
         chart.height = width
@@ -17,12 +27,9 @@ Item {
         chart.width = height + 2*chart.plotArea.x
     }
 
-    function draw(points, depth, initPos) {
-        chart.draw(points, depth, initPos)
-        correctChartSize()
-    }
     onWidthChanged: correctChartSize()
     onHeightChanged: correctChartSize()
+    Component.onCompleted: correctChartSize()
 
     ChartView {
         id: chart
@@ -95,22 +102,6 @@ Item {
             color: 'lime'
         }
 
-        function draw(points, depth, initPost) {
-            if (points) {
-                Util.update(serie, points, initPost, depth, minDepthToDraw, maxDepthToDraw, 1)
-                Util.update(serieInv, points, initPost, depth, minDepthToDraw, maxDepthToDraw, -1)
-                return
-            }
-
-            serie.clear()
-            serieInv.clear()
-            for (var i=0; i<200; i++) {
-                var pt = 255*Math.random()
-                serie.append(i, pt)
-                serieInv.append(i, -pt)
-            }
-        }
-
         Component.onCompleted: {
             for(var id in axes) {
                 axes[id].visible = false
@@ -75,6 +75,37 @@ Item {
                         onCurrentTextChanged: StyleManager.isDark = !currentIndex
                     }
 
+                    Text {
+                        text: "History zoom:"
+                        color: Material.primary
+                    }
+
+                    ComboBox {
+                        id: historyLevelCB
+                        Layout.columnSpan:  4
+                        Layout.fillWidth: true
+                        model: ["1x", "4x", "16x", "64x"]
+                        currentIndex: waterfallItem.historyLevel
+                        onCurrentIndexChanged: waterfallItem.historyLevel = currentIndex
+                    }
+
+                    Text {
+                        text: "History position:"
+                        color: Material.primary
+                    }
+
+                    Slider {
+                        id: historyOffsetSlider
+                        Layout.columnSpan:  4
+                        Layout.fillWidth: true
+                        // Left is the oldest column and right the newest one
+                        from: Math.max(waterfallItem.historySize - 1, 0)
+                        to: 0
+                        stepSize: 1
+                        value: waterfallItem.historyOffset
+                        onMoved: waterfallItem.historyOffset = value
+                    }
+
                     CheckBox {
                         id: replayChB
                         text: "Enable replay menu"
@@ -142,6 +142,21 @@ Item {
                 }
             }
 
+            ComboBox {
+                id: replaySpeedCB
+                // The last option plays the log as fast as possible
+                property var speeds: [0.25, 0.5, 1, 2, 5, 10, 50, 100]
+                enabled: !ping.link.isWritable()
+                model: ["0.25x", "0.5x", "1x", "2x", "5x", "10x", "50x", "100x", "Max"]
+                currentIndex: ping.link.isMaxSpeed ? speeds.length : speeds.indexOf(ping.link.playbackSpeed)
+                onActivated: {
+                    ping.link.isMaxSpeed = index === speeds.length
+                    if(index < speeds.length) {
+                        ping.link.playbackSpeed = speeds[index]
+                    }
+                }
+            }
+
             Text {
                 id: timeText
                 text: "Time:"
@@ -152,15 +167,27 @@ Item {
                 id: replaySlider
                 enabled: !ping.link.isWritable()
                 from: 0
-                value: ping.link.packageIndex
-                stepSize: 1
-                to: ping.link.packageSize
-                onValueChanged: {
-                    if(ping.link.packageIndex !== value) {
-                        ping.link.packageIndex = value
-                        ping.link.start()
+                value: ping.link.elapsedMSecs
+                to: ping.link.totalMSecs
+                // Each seek sends the previous packages again, limit the rate while scrubbing
+                onMoved: {
+                    if(!replaySeekTimer.running) {
+                        replaySeekTimer.start()
                     }
                 }
+
+                Timer {
+                    id: replaySeekTimer
+                    interval: 100
+                    onTriggered: ping.link.seek(replaySlider.value)
+                }
+            }
+
+            Text {
+                id: replayIndexing
+                visible: ping.link.indexProgress < 1
+                text: "Indexing: " + (ping.link.indexProgress * 100).toFixed(0) + "%"
+                color: Material.primary
             }
 
             Text {
@@ -212,9 +239,10 @@ Item {
     Ping {
         id: ping
 
-        onPointsUpdate: {
-            // Move from mm to m
-            ping1DVisualizer.draw(ping.points, ping.confidence, ping.start_mm*1e-3, ping.length_mm * 1e-3, ping.distance*1e-3)
+        // Profiles are sent to the waterfall and chart directly from C++
+        Component.onCompleted: {
+            ping.addProfileSink(ping1DVisualizer.waterfallItem)
+            ping.addProfileSink(ping1DVisualizer.chartProfileSink)
         }
 
         onDistanceUpdate: {
@@ -12,6 +12,7 @@ import StyleManager 1.0
 Item {
     id: visualizer
     property alias waterfallItem: waterfall
+    property alias chartProfileSink: chart.profileSink
     property var protocol
 
     onWidthChanged: {
@@ -20,11 +21,6 @@ Item {
         }
     }
 
-    function draw(points, confidence, initialPoint, length, distance) {
-        waterfall.draw(points, confidence, initialPoint, length, distance)
-        chart.draw(points, length + initialPoint, initialPoint)
-    }
-
     function setDepth(depth) {
         depthAxis.depth_mm = depth
         readout.value = depth
@@ -166,6 +166,14 @@ Item {
                     font.pointSize: 8
                 }
             }
+            Row {
+                Text {
+                    text: "Profile jitter (ms): " + ping.profile_jitter.toFixed(2)
+                    color: "white"
+                    font.family: "unicode"
+                    font.pointSize: 8
+                }
+            }
             Row {
                 Text {
                     text: "Ascii text:\n" + ping.ascii_text
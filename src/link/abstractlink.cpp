@@ -3,8 +3,6 @@
 #include "abstractlink.h"
 #include "abstractlinknamespace.h"
 
-const QString AbstractLink::_timeFormat = QStringLiteral("hh:mm:ss.zzz");
-
 AbstractLink::AbstractLink(QObject* parent)
     : QObject(parent)
     , _type(LinkType::None)
@@ -19,6 +17,13 @@ const AbstractLink& AbstractLink::operator=(const AbstractLink& other)
     return *this;
 }
 
+QString AbstractLink::timeString(qint64 msecs)
+{
+    const QLatin1Char zero('0');
+    return QStringLiteral("%1:%2:%3.%4").arg(msecs/3600000, 2, 10, zero).arg(msecs/60000%60, 2, 10, zero)
+           .arg(msecs/1000%60, 2, 10, zero).arg(msecs%1000, 3, 10, zero);
+}
+
 AbstractLink::~AbstractLink()
 {
     finishConnection();
@@ -1,7 +1,6 @@
 #pragma once
 
 #include <QObject>
-#include <QTime>
 
 #include "linkconfiguration.h"
 
@@ -42,18 +41,18 @@ public:
     LinkConfiguration* configuration() { return &_linkConfiguration; }
 
     /**
-     * @brief Return elapsed time of connection
+     * @brief Return elapsed time of connection in milliseconds
      *
-     * @return QTime
+     * @return qint64
      */
-    Q_INVOKABLE virtual QTime elapsedTime() { return QTime(); };
+    Q_INVOKABLE virtual qint64 elapsedMSecs() { return 0; };
 
     /**
      * @brief Return elapsed time in string format
      *
      * @return QString
      */
-    Q_INVOKABLE virtual QString elapsedTimeString() { return elapsedTime().toString(_timeFormat); };
+    Q_INVOKABLE QString elapsedTimeString() { return timeString(elapsedMSecs()); };
 
     /**
      * @brief Return error in a human friendly message
@@ -77,6 +76,22 @@ public:
      */
     bool isAutoConnect() { return _autoConnect; }
 
+    /**
+     * @brief Return the fraction of the offline source that is indexed
+     *  Packages can be played before the source is completely indexed
+     *
+     * @return float between 0 and 1
+     */
+    Q_INVOKABLE virtual float indexProgress() { return 1; };
+
+    /**
+     * @brief Check if data is sent as fast as the receiver handles it
+     *
+     * @return true
+     * @return false
+     */
+    Q_INVOKABLE virtual bool isMaxSpeed() { return false; };
+
     /**
      * @brief Check if connection is open
      *
@@ -119,6 +134,21 @@ public:
      */
     Q_INVOKABLE virtual void pause() {};
 
+    /**
+     * @brief Return the playback speed factor
+     *
+     * @return float
+     */
+    Q_INVOKABLE virtual float playbackSpeed() { return 1; };
+
+    /**
+     * @brief Inform that the receiver handled the data that was received
+     *  Links that control the data rate (E.g: logs) wait for it to send more data when the receiver can't keep up.
+     *  It can be called from any thread
+     *
+     */
+    virtual void receiverReady() {};
+
     /**
      * @brief Return the link name
      *
@@ -126,6 +156,14 @@ public:
      */
     const QString name() { return _name; }
 
+    /**
+     * @brief Seek to an elapsed time
+     *  Links that can seek emit seeked before sending the packages that are played again
+     *
+     * @param msecs
+     */
+    Q_INVOKABLE virtual void seek(qint64 msecs) { Q_UNUSED(msecs) };
+
     /**
      * @brief Set the auto connection state
      *
@@ -133,6 +171,13 @@ public:
      */
     virtual void setAutoConnect(bool autoc = true) { _autoConnect = autoc; emit autoConnectChanged(); }
 
+    /**
+     * @brief Send data as fast as the receiver handles it, used to process logs
+     *
+     * @param maxSpeed
+     */
+    Q_INVOKABLE virtual void setMaxSpeed(bool maxSpeed) { Q_UNUSED(maxSpeed) };
+
     /**
      * @brief Set the configuration object
      *
@@ -156,6 +201,13 @@ public:
      */
     Q_INVOKABLE virtual void setPackageIndex(int index) { Q_UNUSED(index) };
 
+    /**
+     * @brief Set the playback speed factor
+     *
+     * @param speed
+     */
+    Q_INVOKABLE virtual void setPlaybackSpeed(float speed) { Q_UNUSED(speed) };
+
     /**
      * @brief Set link type
      *
@@ -176,18 +228,18 @@ public:
     Q_INVOKABLE virtual bool startConnection() { return true;};
 
     /**
-     * @brief Return total time
+     * @brief Return total time in milliseconds
      *
-     * @return QTime
+     * @return qint64
      */
-    Q_INVOKABLE virtual QTime totalTime() { return QTime(); };
+    Q_INVOKABLE virtual qint64 totalMSecs() { return 0; };
 
     /**
      * @brief Return total time in string
      *
      * @return QString
      */
-    Q_INVOKABLE virtual QString totalTimeString() { return totalTime().toString(_timeFormat); };
+    Q_INVOKABLE QString totalTimeString() { return timeString(totalMSecs()); };
 
     /**
      * @brief Return LinkType
@@ -226,14 +278,17 @@ public:
 
     Q_PROPERTY(qint64 byteSize READ byteSize NOTIFY byteSizeChanged)
     Q_PROPERTY(LinkConfiguration* configuration READ configuration CONSTANT)
-    Q_PROPERTY(QTime elapsedTime READ elapsedTime NOTIFY elapsedTimeChanged)
+    Q_PROPERTY(qint64 elapsedMSecs READ elapsedMSecs WRITE seek NOTIFY elapsedTimeChanged)
     Q_PROPERTY(QString elapsedTimeString READ elapsedTimeString NOTIFY elapsedTimeChanged)
+    Q_PROPERTY(float indexProgress READ indexProgress NOTIFY indexProgressChanged)
     Q_PROPERTY(bool isAutoConnect READ isAutoConnect WRITE setAutoConnect NOTIFY autoConnectChanged)
+    Q_PROPERTY(bool isMaxSpeed READ isMaxSpeed WRITE setMaxSpeed NOTIFY playbackSpeedChanged)
     Q_PROPERTY(QStringList listAvailableConnections READ listAvailableConnections NOTIFY availableConnectionsChanged)
     Q_PROPERTY(QString name READ name WRITE setName NOTIFY nameChanged)
     Q_PROPERTY(int packageIndex READ packageIndex WRITE setPackageIndex NOTIFY packageIndexChanged)
     Q_PROPERTY(int packageSize READ packageSize NOTIFY packageSizeChanged)
-    Q_PROPERTY(QTime totalTime READ totalTime NOTIFY totalTimeChanged)
+    Q_PROPERTY(float playbackSpeed READ playbackSpeed WRITE setPlaybackSpeed NOTIFY playbackSpeedChanged)
+    Q_PROPERTY(qint64 totalMSecs READ totalMSecs NOTIFY totalTimeChanged)
     Q_PROPERTY(QString totalTimeString READ totalTimeString NOTIFY totalTimeChanged)
     Q_PROPERTY(LinkType type READ type WRITE setType NOTIFY linkChanged)
 
@@ -250,9 +305,20 @@ signals:
     void packageIndexChanged();
     void totalTimeChanged();
     void elapsedTimeChanged();
+    void indexProgressChanged();
+    void playbackSpeedChanged();
+    // Packages from preRollIndex to index - 1 are sent again after a seek to rebuild the sensor state
+    void seeked(int preRollIndex, int index);
 
 protected:
-    static const QString _timeFormat;
+    /**
+     * @brief Return a time in hh:mm:ss.zzz format, hours are not limited to a day
+     *
+     * @param msecs
+     * @return QString
+     */
+    static QString timeString(qint64 msecs);
+
     LinkConfiguration _linkConfiguration;
 
 private:
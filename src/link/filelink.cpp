@@ -7,15 +7,22 @@
 #include <QUrl>
 
 #include "filelink.h"
+#include "filemanager.h"
 
 Q_LOGGING_CATEGORY(PING_PROTOCOL_FILELINK, "ping.protocol.filelink")
 
 FileLink::FileLink(QObject* parent)
     : AbstractLink(parent)
     , _openModeFlag(QIODevice::ReadWrite)
-    , _time(QTime::currentTime())
-    , _inout(&_file)
     , _logThread(nullptr)
+    , _packageIndex(0)
+    , _packageSize(0)
+    , _elapsedMSecs(0)
+    , _totalMSecs(0)
+    , _playbackSpeed(1)
+    , _maxSpeed(false)
+    , _indexerId(0)
+    , _indexProgress(1)
 {
     setType(LinkType::File);
 
@@ -27,17 +34,17 @@ void FileLink::_writeData(const QByteArray& data)
     // Check if we have already opened the file
     if(!_file.isOpen()) {
         qCDebug(PING_PROTOCOL_FILELINK) << "File will be opened.";
-        if(!_file.open(QIODevice::ReadWrite)) {
+        // The log header is updated with the index position when the log finishes
+        if(!_file.open(QIODevice::ReadWrite | QIODevice::Truncate) || !_writer.begin(&_file)) {
             qCDebug(PING_PROTOCOL_FILELINK) << "File was not open.";
             return;
         }
     }
 
-    // This save the data as a structure to deal with the timestamp
-    if(_openModeFlag == QIODevice::WriteOnly && _file.isWritable()) {
-        QString time = _time.currentTime().toString(_timeFormat);
-        Pack pack{time, data};
-        _inout << pack.time << pack.data;
+    // Each buffer is saved as a record with a monotonic timestamp, check LogFormat
+    if(_openModeFlag == QIODevice::WriteOnly && _writer.isActive()) {
+        // Only the sensor link is logged, it uses the link id 0
+        _writer.write(data);
     } else {
         qCWarning(PING_PROTOCOL_FILELINK) << "Something is wrong!";
         qCDebug(PING_PROTOCOL_FILELINK) << "File is opened as write only:" << (_openModeFlag == QIODevice::WriteOnly);
@@ -76,35 +83,38 @@ bool FileLink::startConnection()
     }
 
     // Everything after this point is to deal with reading data
-    bool ok = _file.open(QIODevice::ReadWrite);
+    bool ok = _file.open(QIODevice::ReadOnly) && _reader.open(&_file);
+    if(!ok && _file.isOpen()) {
+        // Logs with an unsupported version or an invalid header are closed, so the next connection can open the file
+        qCWarning(PING_PROTOCOL_FILELINK) << "Invalid log:" << _file.fileName();
+        _file.close();
+    }
     if(ok) {
-        Pack pack;
         if(_logThread) {
             // Disconnect LogThread
-            disconnect(_logThread.get(), &LogThread::newPackage, this, &FileLink::newData);
-            disconnect(_logThread.get(), &LogThread::packageIndexChanged, this, &FileLink::packageIndexChanged);
-            disconnect(_logThread.get(), &LogThread::packageIndexChanged, this, &FileLink::elapsedTimeChanged);
+            disconnect(_logThread.get(), nullptr, this, nullptr);
         }
         _logThread.reset(new LogThread());
+        // The state is updated before the notifications are sent to other threads
+        connect(_logThread.get(), &LogThread::packageIndexChanged, this, &FileLink::updateLogState);
+        connect(_logThread.get(), &LogThread::speedChanged, this, &FileLink::updateLogState);
         connect(_logThread.get(), &LogThread::newPackage, this, &FileLink::newData);
         connect(_logThread.get(), &LogThread::packageIndexChanged, this, &FileLink::packageIndexChanged);
         connect(_logThread.get(), &LogThread::packageIndexChanged, this, &FileLink::elapsedTimeChanged);
-        while(true) {
-            // Get data
-            _inout >> pack.time >> pack.data;
-
-            // Check if we have a new package
-            if(pack.time.isEmpty()) {
-                qCDebug(PING_PROTOCOL_FILELINK) << "No more packages !";
-                break;
-            }
-
-            QTime time = QTime::fromString(pack.time, _timeFormat);
-            _logThread->append(time, pack.data);
+        connect(_logThread.get(), &LogThread::seeked, this, &FileLink::seeked);
+        connect(_logThread.get(), &LogThread::speedChanged, this, &FileLink::playbackSpeedChanged);
+        // Only the index is loaded, packages are read from the mapped file while playing
+        _logThread->setReader(&_reader);
+        if(!_reader.isIndexed() && !_reader.loadIndex(indexCacheFileName())) {
+            startIndexer();
         }
+        qCDebug(PING_PROTOCOL_FILELINK) << "Log opened with" << _reader.size() << "packages, format version"
+                                        << _reader.version();
         _logThread->start();
+        updateLogState();
         emit elapsedTimeChanged();
         emit totalTimeChanged();
+        emit playbackSpeedChanged();
     }
     return ok;
 };
@@ -119,6 +129,13 @@ bool FileLink::isOpen()
 
 bool FileLink::finishConnection()
 {
+    // Logs are only indexed when they are finished
+    if(_writer.isActive()) {
+        _writer.finish();
+    }
+    stopIndexer();
+    _reader.close();
+
     // Only close files that are open
     if(_file.isOpen()) {
         _file.close();
@@ -126,6 +143,99 @@ bool FileLink::finishConnection()
     return true;
 }
 
+int FileLink::packageIndex()
+{
+    // Messages are parsed in the link thread while their package is played
+    if(_logThread && thread() == QThread::currentThread()) {
+        return _logThread->packageIndex();
+    }
+    return _packageIndex;
+}
+
+void FileLink::updateLogState()
+{
+    _packageIndex = _logThread->packageIndex();
+    _packageSize = _logThread->packageSize();
+    _elapsedMSecs = _logThread->elapsedMSecs();
+    _totalMSecs = _logThread->totalMSecs();
+    _playbackSpeed = _logThread->speed();
+    _maxSpeed = _logThread->isMaxSpeed();
+}
+
+QString FileLink::indexCacheFileName() const
+{
+    const QString folder = FileManager::self()->getPathFrom(FileManager::Folder::SensorLog).toLocalFile();
+    return QDir(folder).filePath(QFileInfo(_file).fileName() + QStringLiteral(".index"));
+}
+
+void FileLink::startIndexer()
+{
+    stopIndexer();
+    _indexProgress = 0;
+    emit indexProgressChanged();
+
+    // Records are appended in the link thread, the reader is only used by this thread
+    const int indexerId = ++_indexerId;
+    _indexer.reset(new LogIndexer(_reader.contents(), _reader.indexBegin(), _reader.indexEnd(), _reader.version()));
+    _indexer->setRecordsHandler([this, indexerId](const QVector<LogFormat::Record>& records, float progress) {
+        QMetaObject::invokeMethod(this, [this, indexerId, records, progress] {
+            appendRecords(indexerId, records, progress);
+        }, Qt::QueuedConnection);
+    });
+    connect(_indexer.get(), &LogIndexer::finished, this, [this, indexerId] { finishIndex(indexerId); });
+    connect(&_indexerThread, &QThread::started, _indexer.get(), &LogIndexer::run);
+    _indexer->moveToThread(&_indexerThread);
+    _indexerThread.start(QThread::LowPriority);
+}
+
+void FileLink::stopIndexer()
+{
+    if(!_indexer) {
+        return;
+    }
+
+    // The indexer reads the mapped file, it should be stopped before the file is unmapped
+    _indexer->stop();
+    _indexerThread.quit();
+    _indexerThread.wait();
+    _indexer.reset();
+}
+
+void FileLink::appendRecords(int indexerId, const QVector<LogFormat::Record>& records, float progress)
+{
+    if(indexerId != _indexerId || !_indexer) {
+        return;
+    }
+
+    _reader.appendRecords(records);
+    _indexProgress = progress;
+    if(_logThread) {
+        _logThread->packagesAppended();
+        updateLogState();
+    }
+    emit indexProgressChanged();
+    emit packageSizeChanged();
+    emit totalTimeChanged();
+}
+
+void FileLink::finishIndex(int indexerId)
+{
+    if(indexerId != _indexerId || !_indexer) {
+        return;
+    }
+
+    stopIndexer();
+    _reader.setIndexed();
+    _indexProgress = 1;
+    emit indexProgressChanged();
+
+    if(!_reader.saveIndex(indexCacheFileName())) {
+        qCWarning(PING_PROTOCOL_FILELINK) << "Failed to save log index in" << indexCacheFileName();
+    }
+    qCDebug(PING_PROTOCOL_FILELINK) << "Log indexed with" << _reader.size() << "packages.";
+}
+
 FileLink::~FileLink()
 {
+    finishConnection();
 }
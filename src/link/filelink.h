@@ -1,13 +1,16 @@
 #pragma once
 
-#include <QDataStream>
 #include <QFile>
-#include <QTime>
+#include <QThread>
 
+#include <atomic>
 #include <memory>
 
 #include "abstractlink.h"
+#include "logindexer.h"
+#include "logreader.h"
 #include "logthread.h"
+#include "logwriter.h"
 
 /**
  * @brief File connection class
@@ -32,11 +35,11 @@ public:
     qint64 byteSize() final { return _file.bytesAvailable(); };
 
     /**
-     * @brief Return elapsed time of log
+     * @brief Return elapsed time of log in milliseconds
      *
-     * @return QTime
+     * @return qint64
      */
-    QTime elapsedTime() final { return _logThread ? _logThread->elapsedTime() : QTime(); };
+    qint64 elapsedMSecs() final { return _elapsedMSecs; };
 
     /**
      * @brief Return a human friendly error message
@@ -45,6 +48,13 @@ public:
      */
     QString errorString() final { return _file.errorString(); };
 
+    /**
+     * @brief Return the fraction of the log that is indexed
+     *
+     * @return float
+     */
+    float indexProgress() final { return _indexProgress; };
+
     /**
      * @brief Closes connection
      *
@@ -61,6 +71,14 @@ public:
      */
     bool isOpen() final;
 
+    /**
+     * @brief Check if the log is played as fast as the receiver handles it
+     *
+     * @return true
+     * @return false
+     */
+    bool isMaxSpeed() final { return _maxSpeed; };
+
     /**
      * @brief Check if connection is writable
      *
@@ -71,23 +89,54 @@ public:
 
     /**
      * @brief Return package index
+     *  In the link thread it is the package being played, other threads get the last notified package
      *
      * @return int
      */
-    int packageIndex() final { return _logThread ? _logThread->packageIndex() : 0; };
+    int packageIndex() final;
 
     /**
      * @brief Return number of packages
      *
      * @return int
      */
-    int packageSize() final { return _logThread ? _logThread->packageSize() : 0; };
+    int packageSize() final { return _packageSize; };
 
     /**
      * @brief Pause log
      *
      */
-    void pause() final { if(_logThread) _logThread->pauseJob(); };
+    void pause() final { runInThread([this] { _logThread->pauseJob(); }); };
+
+    /**
+     * @brief Return the log speed factor
+     *
+     * @return float
+     */
+    float playbackSpeed() final { return _playbackSpeed; };
+
+    /**
+     * @brief Inform that the receiver handled the packages
+     *
+     */
+    void receiverReady() final { runInThread([this] { _logThread->receiverReady(); }); };
+
+    /**
+     * @brief Seek to an elapsed time
+     *
+     * @param msecs
+     */
+    void seek(qint64 msecs) final { runInThread([this, msecs] { _logThread->seek(msecs); }); };
+
+    /**
+     * @brief Play the log as fast as the receiver handles it
+     *
+     * @param maxSpeed
+     */
+    void setMaxSpeed(bool maxSpeed) final
+    {
+        runInThread([this, maxSpeed] { _logThread->setMaxSpeed(maxSpeed); });
+    };
 
     /**
      * @brief Set the configuration object
@@ -103,13 +152,20 @@ public:
      *
      * @param index
      */
-    void setPackageIndex(int index) { if(_logThread) _logThread->setPackageIndex(index); }
+    void setPackageIndex(int index) { runInThread([this, index] { _logThread->setPackageIndex(index); }); }
+
+    /**
+     * @brief Set the log speed factor
+     *
+     * @param speed
+     */
+    void setPlaybackSpeed(float speed) final { runInThread([this, speed] { _logThread->setSpeed(speed); }); };
 
     /**
      * @brief Start log
      *
      */
-    void start() final { if(_logThread) _logThread->startJob(); };
+    void start() final { runInThread([this] { _logThread->startJob(); }); };
 
     /**
      * @brief Start connection
@@ -120,25 +176,92 @@ public:
     bool startConnection() final;
 
     /**
-     * @brief Return log total time
+     * @brief Return log total time in milliseconds
      *
-     * @return QTime
+     * @return qint64
      */
-    QTime totalTime() final { return _logThread ? _logThread->totalTime() : QTime(); };
+    qint64 totalMSecs() final { return _totalMSecs; };
 
 private:
-    struct Pack {
-        QString time;
-        QByteArray data;
-    };
-
     QIODevice::OpenModeFlag _openModeFlag;
-    QTime _time;
 
     QFile _file;
-    QDataStream _inout;
+    LogReader _reader;
+    LogWriter _writer;
 
+    // Lives in the link thread and is replaced there when a log is opened, other threads use the values below
     std::unique_ptr<LogThread> _logThread;
+    std::atomic<int> _packageIndex;
+    std::atomic<int> _packageSize;
+    std::atomic<qint64> _elapsedMSecs;
+    std::atomic<qint64> _totalMSecs;
+    std::atomic<float> _playbackSpeed;
+    std::atomic<bool> _maxSpeed;
+
+    // Logs without index are indexed in a worker thread while they are played
+    QThread _indexerThread;
+    std::unique_ptr<LogIndexer> _indexer;
+    // Identify the indexer that found the records, records from a previous log are ignored
+    int _indexerId;
+    // Written in the link thread and read from other threads, like the log state
+    std::atomic<float> _indexProgress;
+
+    /**
+     * @brief Run a function with the log thread in the link thread
+     *  Calls from other threads are queued, like LogThread does, so their order is kept
+     *
+     * @param function
+     */
+    template<typename Function>
+    void runInThread(Function function)
+    {
+        QMetaObject::invokeMethod(this, [this, function] {
+            if(_logThread) {
+                function();
+            }
+        });
+    }
+
+    /**
+     * @brief Copy the log state for other threads, it is called in the link thread
+     *
+     */
+    void updateLogState();
+
+    /**
+     * @brief Return the index cache file of the log, in the sensor log folder
+     *
+     * @return QString
+     */
+    QString indexCacheFileName() const;
+
+    /**
+     * @brief Start indexing the log in the worker thread
+     *
+     */
+    void startIndexer();
+
+    /**
+     * @brief Stop the worker thread, it should be called before closing the reader
+     *
+     */
+    void stopIndexer();
+
+    /**
+     * @brief Append records found by the indexer
+     *
+     * @param indexerId
+     * @param records
+     * @param progress
+     */
+    void appendRecords(int indexerId, const QVector<LogFormat::Record>& records, float progress);
+
+    /**
+     * @brief Finish the index and save it in the cache
+     *
+     * @param indexerId
+     */
+    void finishIndex(int indexerId);
 
     void _writeData(const QByteArray& data);
 };
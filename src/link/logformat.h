@@ -0,0 +1,55 @@
+#pragma once
+
+#include <QtGlobal>
+
+/**
+ * @brief Binary sensor log format
+ *  All values are little endian.
+ *
+ *  File header (32 bytes):
+ *      magic "PINGLOG\0" | version (u16) | file header size (u16) | record header size (u16) | reserved (u16)
+ *      start time in milliseconds since epoch, UTC (i64) | index offset (u64), 0 if the log was not closed
+ *  Records, one for each received buffer:
+ *      timestamp in nanoseconds since start time, monotonic (i64) | link id (u16) | flags (u16) | length (u32)
+ *      data
+ *  Index, after the last record:
+ *      magic "PINGIDX\0" | number of entries (u32) | entry size (u32)
+ *      entries: timestamp (i64) | record offset (u64) | length (u32) | link id (u16) | reserved (u16)
+ *
+ *  Logs without a valid index can still be read record by record.
+ *  Logs without the magic are from the previous format, a QDataStream with QString time and QByteArray data pairs.
+ *
+ *  Logs without index are indexed once and the index is cached in a separate file (40 bytes header):
+ *      magic "PINGIDC\0" | log version (u16) | reserved (u16) | entry size (u32) | log size (i64)
+ *      log modification time in milliseconds since epoch (i64) | number of entries (u32) | reserved (u32)
+ *      entries: timestamp (i64) | data offset (u64) | length (u32) | link id (u16) | reserved (u16)
+ */
+namespace LogFormat
+{
+static const char fileMagic[] = "PINGLOG";
+static const char indexMagic[] = "PINGIDX";
+static const char indexCacheMagic[] = "PINGIDC";
+static const int magicSize = 8;
+
+static const quint16 version = 1;
+
+static const int fileHeaderSize = 32;
+static const int indexOffsetPosition = 24;
+static const int recordHeaderSize = 16;
+static const int indexHeaderSize = 16;
+static const int indexEntrySize = 24;
+static const int indexCacheHeaderSize = 40;
+
+/**
+ * @brief Record information, this is what the index keeps
+ *
+ */
+struct Record {
+    // Nanoseconds since the log start
+    qint64 timestamp;
+    // Position of the record data in the file, the index keeps the position of the record header
+    qint64 offset;
+    quint32 length;
+    quint16 linkId;
+};
+}
@@ -0,0 +1,114 @@
+#include <QString>
+#include <QTime>
+#include <QtEndian>
+
+#include "logindexer.h"
+
+LogIndexer::LogIndexer(const uchar* data, qint64 begin, qint64 end, int version, QObject* parent)
+    : QObject(parent)
+    , _data(data)
+    , _begin(begin)
+    , _position(begin)
+    , _end(end)
+    , _version(version)
+    , _stop(false)
+    , _firstMSecs(-1)
+    , _lastMSecs(-1)
+    , _dayOffset(0)
+{
+}
+
+void LogIndexer::run()
+{
+    QVector<LogFormat::Record> records;
+    records.reserve(chunkSize);
+    LogFormat::Record record;
+    while(!_stop && (_version ? nextRecord(record) : nextLegacyRecord(record))) {
+        records.append(record);
+        if(records.size() == chunkSize) {
+            if(_handler) {
+                _handler(records, (_position - _begin)/float(qMax<qint64>(1, _end - _begin)));
+            }
+            records.clear();
+        }
+    }
+
+    if(_stop) {
+        return;
+    }
+
+    if(_handler) {
+        _handler(records, 1);
+    }
+    emit finished();
+}
+
+bool LogIndexer::nextRecord(LogFormat::Record& record)
+{
+    // The last record can be incomplete if the log was not closed
+    if(_position + LogFormat::recordHeaderSize > _end) {
+        return false;
+    }
+
+    const uchar* header = _data + _position;
+    record.timestamp = qFromLittleEndian<qint64>(header);
+    record.linkId = qFromLittleEndian<quint16>(header + 8);
+    record.length = qFromLittleEndian<quint32>(header + 12);
+    record.offset = _position + LogFormat::recordHeaderSize;
+    if(record.offset + record.length > _end) {
+        return false;
+    }
+
+    _position = record.offset + record.length;
+    return true;
+}
+
+bool LogIndexer::nextLegacyRecord(LogFormat::Record& record)
+{
+    /*
+        QDataStream pairs, with big endian sizes:
+            time: byte length (u32) | UTF-16 "hh:mm:ss.zzz"
+            data: length (u32) | data
+    */
+    static const QString timeFormat = QStringLiteral("hh:mm:ss.zzz");
+    static const qint64 msecsPerDay = 24*60*60*1000LL;
+    static const quint32 nullSize = 0xffffffff;
+
+    // Check if we have a new package
+    if(_position + 4 > _end) {
+        return false;
+    }
+    const quint32 timeSize = qFromBigEndian<quint32>(_data + _position);
+    if(!timeSize || timeSize == nullSize || timeSize > 64 || _position + 8 + timeSize > _end) {
+        return false;
+    }
+
+    // Time characters are ASCII, only the low byte is used
+    QString time(timeSize/2, QChar());
+    for(int i = 0; i < time.size(); i++) {
+        time[i] = QChar(_data[_position + 4 + 2*i + 1]);
+    }
+    const qint64 dataPosition = _position + 8 + timeSize;
+
+    quint32 length = qFromBigEndian<quint32>(_data + _position + 4 + timeSize);
+    length = length == nullSize ? 0 : length;
+    if(dataPosition + length > _end) {
+        return false;
+    }
+
+    // The time has no date, logs that pass midnight go back in time
+    qint64 msecs = QTime::fromString(time, timeFormat).msecsSinceStartOfDay() + _dayOffset;
+    if(_lastMSecs >= 0 && msecs < _lastMSecs - msecsPerDay/2) {
+        _dayOffset += msecsPerDay;
+        msecs += msecsPerDay;
+    }
+    _lastMSecs = msecs;
+    if(_firstMSecs < 0) {
+        _firstMSecs = msecs;
+    }
+
+    // Timestamps start with the log
+    record = {(msecs - _firstMSecs)*1000000, dataPosition, length, 0};
+    _position = dataPosition + length;
+    return true;
+}
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <atomic>
+#include <functional>
+
+#include <QObject>
+#include <QVector>
+
+#include "logformat.h"
+
+/**
+ * @brief Find the records of logs without index
+ *  The log data is read from memory, usually the memory mapped file, so it can run in a worker thread while the
+ *  records already found are played. Records are delivered in chunks with the scan progress.
+ *
+ */
+class LogIndexer : public QObject
+{
+    Q_OBJECT
+public:
+    /**
+     * @brief Receive records found since the last call, it's called from the thread that runs the indexer
+     *
+     */
+    typedef std::function<void(const QVector<LogFormat::Record>& records, float progress)> RecordsHandler;
+
+    /**
+     * @brief Construct a new Log Indexer object
+     *  The data should be valid until run returns
+     *
+     * @param data log contents
+     * @param begin position of the first record
+     * @param end position after the last record
+     * @param version log format version, 0 for the previous format
+     * @param parent
+     */
+    LogIndexer(const uchar* data, qint64 begin, qint64 end, int version, QObject* parent = nullptr);
+
+    /**
+     * @brief Set the records handler
+     *
+     * @param handler
+     */
+    void setRecordsHandler(const RecordsHandler& handler) { _handler = handler; };
+
+    /**
+     * @brief Stop the scan, it can be called from any thread
+     *
+     */
+    void stop() { _stop = true; };
+
+    // Number of records in each chunk
+    static const int chunkSize = 4096;
+
+public slots:
+    /**
+     * @brief Scan the log, finished is only emitted if the scan was not stopped
+     *
+     */
+    void run();
+
+signals:
+    void finished();
+
+private:
+    Q_DISABLE_COPY(LogIndexer)
+
+    /**
+     * @brief Find the next record
+     *
+     * @param record
+     * @return true if a complete record was found
+     * @return false
+     */
+    bool nextRecord(LogFormat::Record& record);
+
+    /**
+     * @brief Find the next record of the previous log format
+     *
+     * @param record
+     * @return true if a complete record was found
+     * @return false
+     */
+    bool nextLegacyRecord(LogFormat::Record& record);
+
+    const uchar* _data;
+    qint64 _begin;
+    qint64 _position;
+    qint64 _end;
+    int _version;
+    RecordsHandler _handler;
+    std::atomic<bool> _stop;
+
+    // Time of the previous log format, in milliseconds since the start of the day
+    qint64 _firstMSecs;
+    qint64 _lastMSecs;
+    qint64 _dayOffset;
+};
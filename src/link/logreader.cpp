@@ -0,0 +1,245 @@
+#include <algorithm>
+#include <cstring>
+
+#include <QDataStream>
+#include <QFile>
+#include <QFileInfo>
+#include <QLoggingCategory>
+#include <QSaveFile>
+#include <QtEndian>
+
+#include "logindexer.h"
+#include "logreader.h"
+
+Q_LOGGING_CATEGORY(PING_PROTOCOL_LOGREADER, "ping.protocol.logreader")
+
+LogReader::~LogReader()
+{
+    close();
+}
+
+bool LogReader::open(QFile* file)
+{
+    close();
+    if(!file || !file->isReadable()) {
+        return false;
+    }
+    _file = file;
+    _size = _file->size();
+
+    // Pages are only loaded by the system when they are accessed
+    _map = _size ? _file->map(0, _size) : nullptr;
+    if(_map) {
+        _data = _map;
+    } else {
+        qCWarning(PING_PROTOCOL_LOGREADER) << "Log can't be mapped, loading it in memory:" << _file->errorString();
+        _file->seek(0);
+        _fileData = _file->readAll();
+        _data = reinterpret_cast<const uchar*>(_fileData.constData());
+        _size = _fileData.size();
+    }
+
+    if(_size < LogFormat::fileHeaderSize || memcmp(_data, LogFormat::fileMagic, LogFormat::magicSize)) {
+        qCDebug(PING_PROTOCOL_LOGREADER) << "No log header, using previous log format.";
+        _dataBegin = 0;
+        _indexBegin = 0;
+        _indexEnd = _size;
+        return true;
+    }
+
+    const uchar* header = _data + LogFormat::magicSize;
+    const quint16 version = qFromLittleEndian<quint16>(header);
+    const quint16 fileHeaderSize = qFromLittleEndian<quint16>(header + 2);
+    const quint16 recordHeaderSize = qFromLittleEndian<quint16>(header + 4);
+    const qint64 startTime = qFromLittleEndian<qint64>(header + 8);
+    const qint64 indexOffset = qFromLittleEndian<qint64>(header + 16);
+    // Version 0 is only used for the previous format, a log with the magic can't have it
+    if(version == 0 || version > LogFormat::version || fileHeaderSize < LogFormat::fileHeaderSize
+            || fileHeaderSize > _size || recordHeaderSize != LogFormat::recordHeaderSize) {
+        qCWarning(PING_PROTOCOL_LOGREADER) << "Unsupported log version:" << version;
+        close();
+        return false;
+    }
+
+    _version = version;
+    _dataBegin = fileHeaderSize;
+    _startTime = QDateTime::fromMSecsSinceEpoch(startTime, Qt::UTC);
+    _hasIndex = indexOffset && readIndex(indexOffset);
+    _indexed = _hasIndex;
+    if(!_hasIndex) {
+        qCWarning(PING_PROTOCOL_LOGREADER) << "Log has no valid index, it needs to be indexed.";
+        const bool validOffset = indexOffset >= fileHeaderSize && indexOffset <= _size;
+        _indexBegin = fileHeaderSize;
+        _indexEnd = validOffset ? indexOffset : _size;
+    }
+
+    qCDebug(PING_PROTOCOL_LOGREADER) << "Log version" << _version << "with" << _records.size() << "records.";
+    return true;
+}
+
+void LogReader::close()
+{
+    if(_map && _file) {
+        _file->unmap(_map);
+    }
+    _map = nullptr;
+    _fileData.clear();
+    _data = nullptr;
+    _size = 0;
+    _file = nullptr;
+
+    _version = 0;
+    _startTime = QDateTime();
+    _hasIndex = false;
+    _indexed = false;
+    _dataBegin = 0;
+    _indexBegin = 0;
+    _indexEnd = 0;
+    _records.clear();
+}
+
+void LogReader::index()
+{
+    if(_indexed || !_data) {
+        return;
+    }
+
+    LogIndexer indexer(_data, _indexBegin, _indexEnd, _version);
+    indexer.setRecordsHandler([this](const QVector<LogFormat::Record>& records, float) {
+        appendRecords(records);
+    });
+    indexer.run();
+    setIndexed();
+}
+
+bool LogReader::loadIndex(const QString& fileName)
+{
+    QFile cache(fileName);
+    if(!_file || !cache.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    QDataStream stream(&cache);
+    stream.setByteOrder(QDataStream::LittleEndian);
+    char magic[LogFormat::magicSize];
+    quint16 version, reserved;
+    quint32 entrySize, entries, reserved32;
+    qint64 logSize, logModified;
+    if(stream.readRawData(magic, LogFormat::magicSize) != LogFormat::magicSize
+            || memcmp(magic, LogFormat::indexCacheMagic, LogFormat::magicSize)) {
+        return false;
+    }
+    stream >> version >> reserved >> entrySize >> logSize >> logModified >> entries >> reserved32;
+
+    // The cache is discarded if the log changed
+    const QFileInfo logInfo(*_file);
+    if(stream.status() != QDataStream::Ok || version != _version || entrySize != LogFormat::indexEntrySize
+            || logSize != logInfo.size() || logModified != logInfo.lastModified().toMSecsSinceEpoch()
+            || LogFormat::indexCacheHeaderSize + qint64(entries)*entrySize != cache.size()) {
+        qCDebug(PING_PROTOCOL_LOGREADER) << "Index cache is not valid for this log:" << fileName;
+        return false;
+    }
+
+    QVector<LogFormat::Record> records(entries);
+    for(auto& record : records) {
+        quint64 offset;
+        stream >> record.timestamp >> offset >> record.length >> record.linkId >> reserved;
+        // Offsets are unsigned in the file, they are checked before being used as positions
+        const quint64 recordsEnd = _indexEnd;
+        if(offset < quint64(_dataBegin) || offset > recordsEnd || record.length > recordsEnd - offset) {
+            return false;
+        }
+        record.offset = offset;
+    }
+    if(stream.status() != QDataStream::Ok) {
+        return false;
+    }
+
+    _records = records;
+    _indexed = true;
+    qCDebug(PING_PROTOCOL_LOGREADER) << "Index loaded from cache with" << _records.size() << "records.";
+    return true;
+}
+
+bool LogReader::saveIndex(const QString& fileName) const
+{
+    if(!_file || !_indexed) {
+        return false;
+    }
+
+    // The cache is replaced only when it's complete
+    QSaveFile cache(fileName);
+    if(!cache.open(QIODevice::WriteOnly)) {
+        qCWarning(PING_PROTOCOL_LOGREADER) << "Failed to save index cache:" << cache.errorString();
+        return false;
+    }
+
+    const QFileInfo logInfo(*_file);
+    QDataStream stream(&cache);
+    stream.setByteOrder(QDataStream::LittleEndian);
+    stream.writeRawData(LogFormat::indexCacheMagic, LogFormat::magicSize);
+    stream << quint16(_version) << quint16(0) << quint32(LogFormat::indexEntrySize) << qint64(logInfo.size())
+           << qint64(logInfo.lastModified().toMSecsSinceEpoch()) << quint32(_records.size()) << quint32(0);
+    for(const auto& record : _records) {
+        stream << record.timestamp << quint64(record.offset) << record.length << record.linkId << quint16(0);
+    }
+
+    return stream.status() == QDataStream::Ok && cache.commit();
+}
+
+QByteArray LogReader::data(int index) const
+{
+    if(index < 0 || index >= _records.size()) {
+        return QByteArray();
+    }
+
+    // Data is copied, the mapping is released when the log is closed
+    const auto& record = _records[index];
+    return QByteArray(reinterpret_cast<const char*>(_data + record.offset), record.length);
+}
+
+int LogReader::indexAt(qint64 timestamp) const
+{
+    const auto isBefore = [](const LogFormat::Record& record, qint64 timestamp) {
+        return record.timestamp < timestamp;
+    };
+    return static_cast<int>(std::lower_bound(_records.cbegin(), _records.cend(), timestamp, isBefore)
+                            - _records.cbegin());
+}
+
+bool LogReader::readIndex(qint64 indexOffset)
+{
+    if(indexOffset < _dataBegin || indexOffset > _size - LogFormat::indexHeaderSize
+            || memcmp(_data + indexOffset, LogFormat::indexMagic, LogFormat::magicSize)) {
+        return false;
+    }
+
+    const uchar* header = _data + indexOffset + LogFormat::magicSize;
+    const qint64 entries = qFromLittleEndian<quint32>(header);
+    const qint64 entrySize = qFromLittleEndian<quint32>(header + 4);
+    const qint64 entriesBegin = indexOffset + LogFormat::indexHeaderSize;
+    if(entrySize < LogFormat::indexEntrySize || entries > (_size - entriesBegin)/entrySize) {
+        return false;
+    }
+
+    // Records are between the file header and the index, offsets are unsigned in the file
+    const quint64 recordsBegin = _dataBegin;
+    const quint64 recordsEnd = indexOffset;
+    const uchar* entry = _data + entriesBegin;
+    _records.resize(entries);
+    for(auto& record : _records) {
+        const quint64 headerOffset = qFromLittleEndian<quint64>(entry + 8);
+        record.timestamp = qFromLittleEndian<qint64>(entry);
+        record.length = qFromLittleEndian<quint32>(entry + 16);
+        record.linkId = qFromLittleEndian<quint16>(entry + 20);
+        entry += entrySize;
+
+        if(headerOffset < recordsBegin || headerOffset > recordsEnd - LogFormat::recordHeaderSize
+                || record.length > recordsEnd - LogFormat::recordHeaderSize - headerOffset) {
+            _records.clear();
+            return false;
+        }
+        record.offset = headerOffset + LogFormat::recordHeaderSize;
+    }
+    return true;
+}
@@ -0,0 +1,199 @@
+#pragma once
+
+#include <QByteArray>
+#include <QDateTime>
+#include <QVector>
+
+#include "logformat.h"
+
+class QFile;
+
+/**
+ * @brief Read sensor logs, check LogFormat
+ *  The file is memory mapped and only the index is kept in memory, record data is copied when requested.
+ *  Logs without index and logs with the previous format need to be indexed with LogIndexer, records can be
+ *  appended while the log is used.
+ *
+ */
+class LogReader
+{
+public:
+    LogReader() = default;
+    ~LogReader();
+
+    /**
+     * @brief Open a log, the file should be open and readable
+     *
+     * @param file
+     * @return true
+     * @return false
+     */
+    bool open(QFile* file);
+
+    /**
+     * @brief Close the log, the file is not closed
+     *
+     */
+    void close();
+
+    /**
+     * @brief Return the log format version, 0 for the previous format
+     *
+     * @return int
+     */
+    int version() const { return _version; };
+
+    /**
+     * @brief Return the time when the log started, invalid for the previous format
+     *
+     * @return QDateTime
+     */
+    QDateTime startTime() const { return _startTime; };
+
+    /**
+     * @brief Check if the log was opened with the index
+     *  Logs that were not closed correctly have no index
+     *
+     * @return true
+     * @return false
+     */
+    bool hasIndex() const { return _hasIndex; };
+
+    /**
+     * @brief Check if all records are known
+     *
+     * @return true
+     * @return false
+     */
+    bool isIndexed() const { return _indexed; };
+
+    /**
+     * @brief Index the log in the current thread, it does nothing if the log is already indexed
+     *
+     */
+    void index();
+
+    /**
+     * @brief Return the log contents, used to index the log
+     *
+     * @return const uchar*
+     */
+    const uchar* contents() const { return _data; };
+
+    /**
+     * @brief Return the position of the first record that is not indexed
+     *
+     * @return qint64
+     */
+    qint64 indexBegin() const { return _indexBegin; };
+
+    /**
+     * @brief Return the position after the last record
+     *
+     * @return qint64
+     */
+    qint64 indexEnd() const { return _indexEnd; };
+
+    /**
+     * @brief Append records found by LogIndexer
+     *
+     * @param records
+     */
+    void appendRecords(const QVector<LogFormat::Record>& records) { _records.append(records); };
+
+    /**
+     * @brief Set that all records are known
+     *
+     */
+    void setIndexed() { _indexed = true; };
+
+    /**
+     * @brief Load a cached index, check LogFormat
+     *  The cache is only used if it was created with the same log file
+     *
+     * @param fileName
+     * @return true
+     * @return false
+     */
+    bool loadIndex(const QString& fileName);
+
+    /**
+     * @brief Save the index, check LogFormat
+     *
+     * @param fileName
+     * @return true
+     * @return false
+     */
+    bool saveIndex(const QString& fileName) const;
+
+    /**
+     * @brief Check if the file is memory mapped
+     *  When the file can't be mapped (E.g: address space limit) it's loaded in memory
+     *
+     * @return true
+     * @return false
+     */
+    bool isMapped() const { return _map; };
+
+    /**
+     * @brief Return number of records
+     *
+     * @return int
+     */
+    int size() const { return _records.size(); };
+
+    /**
+     * @brief Return record information
+     *
+     * @param index
+     * @return const LogFormat::Record&
+     */
+    const LogFormat::Record& record(int index) const { return _records[index]; };
+
+    /**
+     * @brief Return a copy of the record data
+     *
+     * @param index
+     * @return QByteArray
+     */
+    QByteArray data(int index) const;
+
+    /**
+     * @brief Return the first record with a timestamp equal or after a time, using a binary search
+     *  Records are written in time order and the previous format is corrected after midnight
+     *
+     * @param timestamp nanoseconds, in the same clock of the records
+     * @return int size() if all records are older
+     */
+    int indexAt(qint64 timestamp) const;
+
+private:
+    Q_DISABLE_COPY(LogReader)
+
+    /**
+     * @brief Read the index block, records should be between the file header and the index
+     *
+     * @param indexOffset
+     * @return true
+     * @return false
+     */
+    bool readIndex(qint64 indexOffset);
+
+    QFile* _file = nullptr;
+    // File contents, mapped or loaded when the file can't be mapped
+    uchar* _map = nullptr;
+    QByteArray _fileData;
+    const uchar* _data = nullptr;
+    qint64 _size = 0;
+
+    int _version = 0;
+    QDateTime _startTime;
+    bool _hasIndex = false;
+    bool _indexed = false;
+    // Position of the first record, after the file header or 0 for the previous format
+    qint64 _dataBegin = 0;
+    // Part of the log that needs to be indexed
+    qint64 _indexBegin = 0;
+    qint64 _indexEnd = 0;
+    QVector<LogFormat::Record> _records;
+};
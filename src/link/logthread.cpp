@@ -1,54 +1,314 @@
+#include <cmath>
+
 #include <QDebug>
+#include <QThread>
 
+#include "logreader.h"
 #include "logthread.h"
 
+const int LogThread::preRollPackages = 512;
+const int LogThread::maxPendingPackages = 256;
+const float LogThread::minSpeedFactor = 0.25f;
+const float LogThread::maxSpeedFactor = 100.0f;
+
 LogThread::LogThread(QObject *parent)
     :QTimer(parent)
+    ,_reader(nullptr)
     ,_logIndex(0)
+    ,_lastPlayedIndex(-1)
     ,_playLog(true)
+    ,_preRollEnd(-1)
+    ,_speed(1)
+    ,_maxSpeed(false)
+    ,_clockTimestamp(0)
+    ,_pendingPackages(0)
+    ,_flowControl(false)
 {
     setSingleShot(true);
+    setTimerType(Qt::PreciseTimer);
     connect(this, &QTimer::timeout, this, &LogThread::processJob);
+    _clock.start();
+
+    _notifyTimer.setSingleShot(true);
+    _notifyTimer.setInterval(16);
+    connect(&_notifyTimer, &QTimer::timeout, this, [this] { emit packageIndexChanged(currentIndex()); });
+}
+
+void LogThread::pauseJob()
+{
+    // Calls from other threads are queued to keep the order with startJob
+    if(thread() != QThread::currentThread()) {
+        QMetaObject::invokeMethod(this, [this] { pauseJob(); }, Qt::QueuedConnection);
+        return;
+    }
+
+    _playLog = false;
+}
+
+void LogThread::receiverReady()
+{
+    if(thread() != QThread::currentThread()) {
+        QMetaObject::invokeMethod(this, [this] { receiverReady(); }, Qt::QueuedConnection);
+        return;
+    }
+
+    const bool waiting = _pendingPackages >= maxPendingPackages;
+    _flowControl = true;
+    _pendingPackages = 0;
+    if(waiting && (_playLog || _preRollEnd >= 0) && !isActive()) {
+        start(0);
+    }
+}
+
+void LogThread::seek(qint64 msecs)
+{
+    if(thread() != QThread::currentThread()) {
+        QMetaObject::invokeMethod(this, [this, msecs] { seek(msecs); }, Qt::QueuedConnection);
+        return;
+    }
+
+    if(packageSize() < 0) {
+        return;
+    }
+
+    // After the end the last package is used
+    const int index = _reader->indexAt(timestamp(0) + msecs*1000000);
+    seekPackage(qMin(index, packageSize()));
+}
+
+void LogThread::setPackageIndex(int index)
+{
+    if(thread() != QThread::currentThread()) {
+        QMetaObject::invokeMethod(this, [this, index] { setPackageIndex(index); }, Qt::QueuedConnection);
+        return;
+    }
+
+    if(index >= 0 && index <= packageSize()) {
+        seekPackage(index);
+    }
+}
+
+void LogThread::setMaxSpeed(bool maxSpeed)
+{
+    if(thread() != QThread::currentThread()) {
+        QMetaObject::invokeMethod(this, [this, maxSpeed] { setMaxSpeed(maxSpeed); }, Qt::QueuedConnection);
+        return;
+    }
+
+    if(maxSpeed == _maxSpeed) {
+        return;
+    }
+
+    _maxSpeed = maxSpeed;
+    restartClock();
+    if(isActive()) {
+        scheduleNext();
+    }
+    emit speedChanged();
+}
+
+void LogThread::setSpeed(float speed)
+{
+    if(thread() != QThread::currentThread()) {
+        QMetaObject::invokeMethod(this, [this, speed] { setSpeed(speed); }, Qt::QueuedConnection);
+        return;
+    }
+
+    speed = qBound(minSpeedFactor, speed, maxSpeedFactor);
+    if(qFuzzyCompare(speed, _speed)) {
+        return;
+    }
+
+    // The clock continues from the current log time, only the wait for the next package changes
+    _clockTimestamp = playbackTimestamp();
+    _clock.restart();
+    _speed = speed;
+    if(isActive()) {
+        scheduleNext();
+    }
+    emit speedChanged();
+}
+
+void LogThread::seekPackage(int index)
+{
+    stop();
+
+    // Sensor state and profile history only depend on previous packages, they are sent without waiting
+    const int preRollIndex = qMax(0, index - preRollPackages);
+    emit seeked(preRollIndex, index);
+    _logIndex = preRollIndex;
+    _preRollEnd = index;
+    emit packageIndexChanged(currentIndex());
+    sendPreRoll();
+}
+
+void LogThread::sendPreRoll()
+{
+    // A package can have many messages, the pre-roll is sent in batches like a log played at max speed
+    for(int sent = 0; sent < maxPendingPackages && _logIndex < _preRollEnd; sent++) {
+        if(_flowControl && _pendingPackages >= maxPendingPackages) {
+            // receiverReady continues
+            return;
+        }
+        sendPackage(_logIndex);
+        _logIndex++;
+    }
+
+    if(_logIndex < _preRollEnd) {
+        start(0);
+        return;
+    }
+    finishPreRoll();
+}
+
+void LogThread::finishPreRoll()
+{
+    _logIndex = _preRollEnd;
+    _preRollEnd = -1;
+    _lastPlayedIndex = -1;
+    restartClock();
+    emit packageIndexChanged(_logIndex);
+    if(_playLog) {
+        start(0);
+    }
+}
+
+void LogThread::startJob()
+{
+    // Timers can only be started from their own thread
+    if(thread() != QThread::currentThread()) {
+        QMetaObject::invokeMethod(this, [this] { startJob(); }, Qt::QueuedConnection);
+        return;
+    }
+
+    _playLog = true;
+    start(0);
 }
 
 void LogThread::processJob()
 {
+    // The pre-roll of a seek is sent even when the log is paused
+    if(_preRollEnd >= 0) {
+        sendPreRoll();
+        return;
+    }
+
     // Check for pause condition and valid log index
-    if(!_playLog) {
+    if(!_playLog || _logIndex < 0 || _logIndex > packageSize()) {
         return;
     }
 
-    static int lastMSecs = 0;
-    QByteArray& data = _log[_logIndex].data;
-    lastMSecs = _log[_logIndex].time.msecsSinceStartOfDay();
-    emit packageIndexChanged(_logIndex);
-    emit newPackage(data);
+    // The clock starts with the first package, after a pause or a slow receiver it restarts
+    // so the missed packages are not sent in a burst
+    static const double maxDelay = 100e6; // 100ms in nanoseconds
+    if(_lastPlayedIndex < 0
+            || (!_maxSpeed && (playbackTimestamp() - timestamp(_logIndex))/static_cast<double>(_speed) > maxDelay)) {
+        restartClock();
+    }
+
+    // All packages that are due are sent, the package rate is not limited by the timer resolution
+    const qint64 now = playbackTimestamp();
+    for(int sent = 0; sent < maxPendingPackages; sent++) {
+        if(_flowControl && _pendingPackages >= maxPendingPackages) {
+            // receiverReady continues
+            return;
+        }
+
+        if(!_maxSpeed && timestamp(_logIndex) > now) {
+            break;
+        }
+
+        sendPackage(_logIndex);
+
+        // The last known package, packagesAppended continues if the log is being indexed
+        if(_logIndex >= packageSize()) {
+            return;
+        }
+        _logIndex++;
+    }
+
+    scheduleNext();
+}
+
+void LogThread::sendPackage(int index)
+{
+    // Data is only read from the log when the package is played
+    _logIndex = index;
+    _lastPlayedIndex = index;
+    _pendingPackages++;
+    if(!_notifyTimer.isActive()) {
+        _notifyTimer.start();
+    }
+    emit newPackage(_reader->data(index));
+}
 
-    // Check if we have data before sending
-    if(_logIndex < _log.size() - 1) {
-        static int diffMSecs;
+void LogThread::scheduleNext()
+{
+    // The event loop runs between batches, pause and seek calls are not delayed
+    if(_maxSpeed || _preRollEnd >= 0) {
+        start(0);
+        return;
+    }
+
+    // Rounded up, packages are not sent before their time
+    const double wait = (timestamp(_logIndex) - playbackTimestamp())/static_cast<double>(_speed);
+    start(static_cast<int>(qMax(0.0, std::ceil(wait/1e6))));
+}
+
+void LogThread::restartClock()
+{
+    _clockTimestamp = timestamp(_logIndex);
+    _clock.restart();
+}
+
+qint64 LogThread::playbackTimestamp()
+{
+    return _clockTimestamp + static_cast<qint64>(_clock.nsecsElapsed()*static_cast<double>(_speed));
+}
+
+void LogThread::packagesAppended()
+{
+    if(!_playLog || isActive() || _preRollEnd >= 0) {
+        return;
+    }
+
+    // Continue after the last package that was sent
+    if(_lastPlayedIndex == _logIndex && _logIndex < packageSize()) {
         _logIndex++;
-        diffMSecs = _log[_logIndex].time.msecsSinceStartOfDay() - lastMSecs;
-        start(diffMSecs);
+    }
+    if(_lastPlayedIndex != _logIndex) {
+        start(0);
     }
 }
 
-QTime LogThread::totalTime()
+qint64 LogThread::totalMSecs()
 {
-    int totalMSecs = _log.constLast().time.msecsSinceStartOfDay() - _log.constFirst().time.msecsSinceStartOfDay();
-    return QTime::fromMSecsSinceStartOfDay(totalMSecs);
+    return (timestamp(packageSize()) - timestamp(0))/1000000;
 }
 
-QTime LogThread::elapsedTime()
+qint64 LogThread::elapsedMSecs()
 {
-    if(_logIndex < 0) {
-        return QTime::fromMSecsSinceStartOfDay(0);
-    } else if(_logIndex >= _log.size()) {
-        return totalTime();
+    const int index = currentIndex();
+    if(index < 0) {
+        return 0;
+    } else if(index > packageSize()) {
+        return totalMSecs();
     }
 
-    int elapsedMSecs = _log[_logIndex].time.msecsSinceStartOfDay() - _log.constFirst().time.msecsSinceStartOfDay();
-    return QTime::fromMSecsSinceStartOfDay(elapsedMSecs);
+    return (timestamp(index) - timestamp(0))/1000000;
+}
+
+int LogThread::packageSize()
+{
+    return _reader ? _reader->size() - 1 : -1;
+}
+
+qint64 LogThread::timestamp(int index)
+{
+    if(!_reader || index < 0 || index >= _reader->size()) {
+        return 0;
+    }
+    return _reader->record(index).timestamp;
 }
 
 LogThread::~LogThread() = default;
\ No newline at end of file
@@ -1,12 +1,16 @@
 #pragma once
 
 #include <QByteArray>
-#include <QTime>
+#include <QElapsedTimer>
 #include <QTimer>
-#include <QVector>
+
+class LogReader;
 
 /**
  * @brief Play sensor logs
+ *  Packages are read from the log reader when they are played, the log is not loaded in memory.
+ *  The time of each package comes from a playback clock that runs with the speed factor, all packages that are
+ *  due are sent when the timer fires. The receiver can limit the rate with receiverReady.
  *
  */
 class LogThread : public QTimer
@@ -27,19 +31,26 @@ public:
     ~LogThread();
 
     /**
-     * @brief Append new log message
+     * @brief Set the log reader, it should be valid while the log is played
      *
-     * @param time
-     * @param data
+     * @param reader
      */
-    void append(QTime time, QByteArray data) { _log.append(Pack{time, data}); };
+    void setReader(LogReader* reader) { _reader = reader; };
 
     /**
      * @brief Return log elapsed time
      *
-     * @return QTime
+     * @return qint64 milliseconds
+     */
+    qint64 elapsedMSecs();
+
+    /**
+     * @brief Check if packages are played as fast as the receiver handles them
+     *
+     * @return true
+     * @return false
      */
-    QTime elapsedTime();
+    bool isMaxSpeed() const { return _maxSpeed; };
 
     /**
      * @brief Return last package index
@@ -53,47 +64,179 @@ public:
      *
      * @return int
      */
-    int packageSize() { return _log.size() - 1; };
+    int packageSize();
+
+    /**
+     * @brief Continue playing when new packages are available
+     *  Logs can be played while they are indexed, the play stops in the last known package
+     *
+     */
+    void packagesAppended();
 
     /**
      * @brief Pause log
+     *  It can be called from any thread
+     *
+     */
+    void pauseJob();
+
+    /**
+     * @brief Inform that the receiver handled the packages that were sent
+     *  After the first call, no more than maxPendingPackages are sent before the next call.
+     *  It can be called from any thread
+     *
+     */
+    void receiverReady();
+
+    /**
+     * @brief Seek to an elapsed time, the package is found with a binary search of the timestamps
+     *  It can be called from any thread
+     *
+     * @param msecs
+     */
+    void seek(qint64 msecs);
+
+    /**
+     * @brief Play packages as fast as the receiver handles them, the speed factor is not used
+     *  It can be called from any thread
      *
+     * @param maxSpeed
      */
-    void pauseJob() { _playLog = false; };
+    void setMaxSpeed(bool maxSpeed);
 
     /**
      * @brief Set the package index
+     *  It can be called from any thread
      *
      * @param index
      */
-    void setPackageIndex(int index) { if(_logIndex < _log.size()) _logIndex = index; }
+    void setPackageIndex(int index);
+
+    /**
+     * @brief Set the speed factor, between minSpeedFactor and maxSpeedFactor
+     *  It can be called from any thread
+     *
+     * @param speed
+     */
+    void setSpeed(float speed);
+
+    /**
+     * @brief Return the speed factor
+     *
+     * @return float
+     */
+    float speed() const { return _speed; };
 
     /**
      * @brief Start playing log
+     *  It can be called from any thread
      *
      */
-    void startJob() { _playLog = true; start();};
+    void startJob();
 
     /**
      * @brief Return total time of log
      *
-     * @return QTime
+     * @return qint64 milliseconds
      */
-    QTime totalTime();
+    qint64 totalMSecs();
+
+    // Packages sent again before the seek point, it covers the visible part of the waterfall
+    static const int preRollPackages;
+    // Packages sent without receiverReady, it keeps the receiver queue from overflowing when it can't keep up
+    static const int maxPendingPackages;
+    static const float minSpeedFactor;
+    static const float maxSpeedFactor;
 
 signals:
     void newPackage(const QByteArray& data);
+    // Emitted at most once per frame, the UI does not need the intermediate packages
     void packageIndexChanged(int index);
+    void seeked(int preRollIndex, int index);
+    void speedChanged();
 
 private:
     void processJob();
 
-    struct Pack {
-        QTime time;
-        QByteArray data;
-    };
+    /**
+     * @brief Send a package and set it as the current one
+     *
+     * @param index
+     */
+    void sendPackage(int index);
+
+    /**
+     * @brief Move to a package, the packages before it are sent again to rebuild the sensor state
+     *
+     * @param index
+     */
+    void seekPackage(int index);
+
+    /**
+     * @brief Send the next pre-roll packages without waiting for their time
+     *  The receiver limit is used, so the pre-roll of a seek does not overflow its queue
+     *
+     */
+    void sendPreRoll();
+
+    /**
+     * @brief Continue in the seek package after the pre-roll
+     *
+     */
+    void finishPreRoll();
+
+    /**
+     * @brief Return the package shown to the user, the seek package while the pre-roll is sent
+     *
+     * @return int
+     */
+    int currentIndex() const { return _preRollEnd >= 0 ? _preRollEnd : _logIndex; }
+
+    /**
+     * @brief Wait for the next package with the playback clock
+     *
+     */
+    void scheduleNext();
+
+    /**
+     * @brief Restart the playback clock in the current package
+     *
+     */
+    void restartClock();
+
+    /**
+     * @brief Return the log time that should be played now
+     *
+     * @return qint64 nanoseconds, in the same clock of the packages
+     */
+    qint64 playbackTimestamp();
+
+    /**
+     * @brief Return the timestamp of a package
+     *
+     * @param index
+     * @return qint64 nanoseconds since the log start
+     */
+    qint64 timestamp(int index);
 
-    QVector<Pack> _log;
+    LogReader* _reader;
     int _logIndex;
+    // Last package sent, -1 if the current package was not sent yet
+    int _lastPlayedIndex;
     bool _playLog;
+    // Seek package while the packages before it are sent again, -1 without pre-roll
+    int _preRollEnd;
+
+    float _speed;
+    bool _maxSpeed;
+    // Log time of the package where the clock started
+    qint64 _clockTimestamp;
+    QElapsedTimer _clock;
+
+    // Packages sent after the last receiverReady, the limit is only used after the first call
+    int _pendingPackages;
+    bool _flowControl;
+
+    // Limit package index notifications to the display rate
+    QTimer _notifyTimer;
 };
@@ -0,0 +1,68 @@
+#include <QDateTime>
+#include <QIODevice>
+
+#include "logwriter.h"
+
+bool LogWriter::begin(QIODevice* device)
+{
+    if(!device || !device->isWritable()) {
+        return false;
+    }
+
+    _device = device;
+    _stream.setDevice(device);
+    _stream.setByteOrder(QDataStream::LittleEndian);
+    _index.clear();
+
+    _stream.writeRawData(LogFormat::fileMagic, LogFormat::magicSize);
+    _stream << LogFormat::version << quint16(LogFormat::fileHeaderSize) << quint16(LogFormat::recordHeaderSize)
+            << quint16(0) << qint64(QDateTime::currentMSecsSinceEpoch()) << quint64(0);
+    _position = _device->pos();
+    _clock.start();
+
+    return _stream.status() == QDataStream::Ok;
+}
+
+bool LogWriter::write(const QByteArray& data, quint16 linkId, qint64 timestamp)
+{
+    if(!_device) {
+        return false;
+    }
+
+    if(timestamp < 0) {
+        timestamp = _clock.nsecsElapsed();
+    }
+
+    _index.append({timestamp, _position + LogFormat::recordHeaderSize, static_cast<quint32>(data.size()), linkId});
+    _stream << timestamp << linkId << quint16(0) << quint32(data.size());
+    _stream.writeRawData(data.constData(), data.size());
+    _position += LogFormat::recordHeaderSize + data.size();
+
+    return _stream.status() == QDataStream::Ok;
+}
+
+bool LogWriter::finish()
+{
+    if(!_device) {
+        return false;
+    }
+
+    const qint64 indexOffset = _position;
+    _stream.writeRawData(LogFormat::indexMagic, LogFormat::magicSize);
+    _stream << quint32(_index.size()) << quint32(LogFormat::indexEntrySize);
+    for(const auto& record : _index) {
+        const quint64 headerOffset = record.offset - LogFormat::recordHeaderSize;
+        _stream << record.timestamp << headerOffset << record.length << record.linkId << quint16(0);
+    }
+
+    // The index offset is only written when the index is complete
+    bool ok = _stream.status() == QDataStream::Ok && _device->seek(LogFormat::indexOffsetPosition);
+    if(ok) {
+        _stream << quint64(indexOffset);
+        ok = _stream.status() == QDataStream::Ok && _device->seek(_device->size());
+    }
+
+    _stream.setDevice(nullptr);
+    _device = nullptr;
+    return ok;
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <QByteArray>
+#include <QDataStream>
+#include <QElapsedTimer>
+#include <QVector>
+
+#include "logformat.h"
+
+class QIODevice;
+
+/**
+ * @brief Write sensor logs with the binary log format, check LogFormat
+ *  The index is kept in memory and written when the log is finished.
+ *
+ */
+class LogWriter
+{
+public:
+    /**
+     * @brief Start a new log in a device, the file header is written and the clock starts
+     *  The device should be open with write and seek support
+     *
+     * @param device
+     * @return true
+     * @return false
+     */
+    bool begin(QIODevice* device);
+
+    /**
+     * @brief Write a record
+     *
+     * @param data
+     * @param linkId source of the data
+     * @param timestamp nanoseconds since begin, -1 to use the log clock
+     * @return true
+     * @return false
+     */
+    bool write(const QByteArray& data, quint16 linkId = 0, qint64 timestamp = -1);
+
+    /**
+     * @brief Write the index and update the file header, nothing else can be written after it
+     *
+     * @return true
+     * @return false
+     */
+    bool finish();
+
+    /**
+     * @brief Check if a log was started and not finished
+     *
+     * @return true
+     * @return false
+     */
+    bool isActive() const { return _device; };
+
+    /**
+     * @brief Return number of records
+     *
+     * @return int
+     */
+    int size() const { return _index.size(); };
+
+private:
+    QIODevice* _device = nullptr;
+    QDataStream _stream;
+    QElapsedTimer _clock;
+    qint64 _position = 0;
+    QVector<LogFormat::Record> _index;
+};
@@ -1,10 +1,12 @@
 #include <QtMath>
 
+#include "pingframeparser.h"
 #include "pingsimulationlink.h"
 #include "pingmessage/pingmessage_all.h"
 
 PingSimulationLink::PingSimulationLink(QObject* parent)
     : SimulationLink(parent)
+    , _randomUpdateTimer(this)
 {
     connect(&_randomUpdateTimer, &QTimer::timeout, this, &PingSimulationLink::randomUpdate);
     _randomUpdateTimer.start(50);
@@ -44,7 +46,7 @@ void PingSimulationLink::randomUpdate()
         profile.set_profile_data_at(i, point);
     }
 
-    profile.updateChecksum();
+    PingFrameParser::updateChecksum(profile.msgData, profile.msgDataLength());
     emit newData(QByteArray(reinterpret_cast<const char*>(profile.msgData), profile.msgDataLength()));
 
     counter++;
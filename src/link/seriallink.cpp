@@ -9,6 +9,7 @@ Q_LOGGING_CATEGORY(PING_PROTOCOL_SERIALLINK, "ping.protocol.seriallink")
 
 SerialLink::SerialLink(QObject* parent)
     : AbstractLink(parent)
+    , _port(this)
 {
     setType(LinkType::Serial);
 
@@ -8,7 +8,7 @@ Q_LOGGING_CATEGORY(PING_PROTOCOL_UDPLINK, "ping.protocol.udplink")
 
 UDPLink::UDPLink(QObject* parent)
     : AbstractLink(parent)
-    , _udpSocket(new QUdpSocket(parent))
+    , _udpSocket(new QUdpSocket(this))
 {
     setType(LinkType::Udp);
 
@@ -7,6 +7,7 @@
 #include <QRegularExpression>
 
 #include "abstractlink.h"
+#include "chartprofilesink.h"
 #include "filemanager.h"
 #include "linkconfiguration.h"
 #include "logger.h"
@@ -45,6 +46,7 @@ int main(int argc, char *argv[])
     qmlRegisterSingletonType<StyleManager>("StyleManager", 1, 0, "StyleManager", StyleManager::qmlSingletonRegister);
     qmlRegisterSingletonType<Util>("Util", 1, 0, "Util", Util::qmlSingletonRegister);
     qmlRegisterType<Waterfall>("Waterfall", 1, 0, "Waterfall");
+    qmlRegisterType<ChartProfileSink>("ChartProfileSink", 1, 0, "ChartProfileSink");
     qmlRegisterType<Ping>("Ping", 1, 0, "Ping");
     qmlRegisterType<AbstractLink>("AbstractLink", 1, 0, "AbstractLink");
     qmlRegisterType<LinkConfiguration>("LinkConfiguration", 1, 0, "LinkConfiguration");
@@ -1,8 +1,11 @@
 #include "ping.h"
 
+#include <algorithm>
 #include <functional>
+#include <iterator>
 
 #include <QCoreApplication>
+#include <QFile>
 #include <QFileInfo>
 #include <QJsonArray>
 #include <QJsonDocument>
@@ -11,9 +14,11 @@
 #include <QSerialPort>
 #include <QSerialPortInfo>
 #include <QStringList>
+#include <QTextStream>
 #include <QThread>
 #include <QUrl>
 
+#include "filemanager.h"
 #include "hexvalidator.h"
 #include "link/seriallink.h"
 #include "networktool.h"
@@ -23,19 +28,63 @@
 Q_LOGGING_CATEGORY(PING_PROTOCOL_PING, "ping.protocol.ping")
 
 const int Ping::_pingMaxFrequency = 50;
+const int Ping::_keyframeInterval = 100;
+const int Ping::_maxKeyframes = 1024;
 
-Ping::Ping() : Sensor()
+Ping::Ping(bool detect) : Sensor()
+    ,_detect(detect)
 {
-    _points.reserve(_num_points);
-    for (int i = 0; i < _num_points; i++) {
-        _points.append(0);
-    }
-    _parser = new PingParser();
-    connect(dynamic_cast<PingParser*>(_parser), &PingParser::newMessage, this, &Ping::handleMessage);
-    connect(dynamic_cast<PingParser*>(_parser), &PingParser::parseError, this, &Ping::parserErrorsUpdate);
-    connect(link(), &AbstractLink::newData, _parser, &Parser::parseBuffer);
+    // Messages are decoded in the I/O thread and queued without locks, the GUI thread handles them once per frame
+    // Frames are views into the received buffer, they are only copied to the queue
+    _frameParser = new PingFrameParser([this](const uint8_t* data, int length) {
+        const QByteArray message(reinterpret_cast<const char*>(data), length);
+        AbstractLink* logLink = _logLink.load();
+        const int packageIndex = logLink ? logLink->packageIndex() : -1;
+        if(!_messageQueue.push({message, _requestScheduler.timestamp(), packageIndex})) {
+            _droppedMessages++;
+        }
+    });
+    _frameParser->moveToThread(linkThread());
+    connect(linkThread(), &QThread::finished, _frameParser, &QObject::deleteLater);
+    _requestScheduler.setSender(std::bind(&Ping::sendRequest, this, std::placeholders::_1));
+    connect(this, &Sensor::linkUpdate, this, [this] {
+        // Logs can seek, set before the parser is connected so all log messages have their package index
+        AbstractLink* currentLink = link();
+        const bool isLog = currentLink && currentLink->type() == LinkType::File;
+        _logLink = isLog ? currentLink : nullptr;
+        connect(link(), &AbstractLink::newData, _frameParser, &PingFrameParser::parseBuffer, Qt::UniqueConnection);
+
+        // Serial links use 10 bits for each byte (start, 8 data bits and stop), other links return 0 (unknown)
+        _requestScheduler.clear();
+        for(auto& requestedId : requestedIds) {
+            requestedId.received = false;
+        }
+        _lastProfileTimestamp = -1;
+        _lastProfileInterval = -1;
+        _requestScheduler.setLinkCapacity(link() ? link()->configuration()->serialBaudrate()/10 : 0);
+
+        // The seek marker is queued by the I/O thread with the messages, so the messages before it are not affected
+        _seekIndex = -1;
+        _keyframes.clear();
+        _keyframeSpacing = _keyframeInterval;
+        _profilesSinceKeyframe = 0;
+        if(isLog) {
+            connect(currentLink, &AbstractLink::seeked, this, [this](int preRollIndex, int index) {
+                // A frame split between the packages before and after the seek is not valid
+                _frameParser->reset();
+                if(!_messageQueue.push({QByteArray(), _requestScheduler.timestamp(), preRollIndex, index})) {
+                    _droppedMessages++;
+                }
+            }, Qt::DirectConnection);
+        }
+    });
     emit linkUpdate();
 
+    _messageQueueTimer.setTimerType(Qt::PreciseTimer);
+    _messageQueueTimer.setInterval(16);
+    connect(&_messageQueueTimer, &QTimer::timeout, this, &Ping::handleQueuedMessages);
+    _messageQueueTimer.start();
+
     _periodicRequestTimer.setInterval(1000);
     connect(&_periodicRequestTimer, &QTimer::timeout, this, [this] {
         if(!link()->isWritable())
@@ -53,23 +102,25 @@ Ping::Ping() : Sensor()
         }
 
         // Update lost messages count
-        _lostMessages = 0;
-        for(const auto& requestedId : requestedIds)
-        {
-            _lostMessages += requestedId.waiting;
-        }
+        _lostMessages = _requestScheduler.lostRequests();
         emit lostMessagesUpdate();
 
-        request(Ping1DNamespace::Pcb_temperature);
-        request(Ping1DNamespace::Processor_temperature);
-        request(Ping1DNamespace::Voltage_5);
-        request(Ping1DNamespace::Mode_auto);
+        // Housekeeping is only sent when there is no other request and it slows down when the link is busy
+        request(Ping1DNamespace::Pcb_temperature, RequestScheduler::Housekeeping);
+        request(Ping1DNamespace::Processor_temperature, RequestScheduler::Housekeeping);
+        request(Ping1DNamespace::Voltage_5, RequestScheduler::Housekeeping);
+        request(Ping1DNamespace::Mode_auto, RequestScheduler::Housekeeping);
+        _periodicRequestTimer.setInterval(_requestScheduler.housekeepingInterval());
     });
 
     //connectLink(LinkType::Serial, {"/dev/ttyUSB2", "115200"});
 
     connect(this, &Sensor::connectionOpen, this, &Ping::startPreConfigurationProcess);
 
+    if(!_detect) {
+        return;
+    }
+
     // Wait for device id to load the correct settings
     connect(this, &Ping::srcIdUpdate, this, &Ping::setLastPingConfiguration);
 
@@ -117,7 +168,7 @@ void Ping::startPreConfigurationProcess()
     // Request device information
     request(Ping1DNamespace::Ping_enable);
     request(Ping1DNamespace::Mode_auto);
-    request(Ping1DNamespace::Profile);
+    request(Ping1DNamespace::Profile, RequestScheduler::Streaming);
     request(Ping1DNamespace::Firmware_version);
     request(Ping1DNamespace::Device_id);
     request(Ping1DNamespace::Speed_of_sound);
@@ -175,221 +226,425 @@ void Ping::connectLink(LinkType connType, const QStringList& connString)
     startPreConfigurationProcess();
 }
 
-void Ping::handleMessage(PingMessage msg)
+void Ping::addProfileSink(QObject* sink)
 {
-    qCDebug(PING_PROTOCOL_PING) << "Handling Message:" << msg.message_id();
+    if(!qobject_cast<ProfileSink*>(sink)) {
+        qCWarning(PING_PROTOCOL_PING) << "Object does not implement ProfileSink:" << sink;
+        return;
+    }
 
-    auto& requestedId = requestedIds[static_cast<Ping1DNamespace::msg_ping1D_id>(msg.message_id())];
-    if(requestedId.waiting) {
-        requestedId.waiting--;
-        requestedId.ack++;
+    if(!_profileSinks.contains(sink)) {
+        _profileSinks.append(sink);
     }
+}
 
-    switch (msg.message_id()) {
+void Ping::removeProfileSink(QObject* sink)
+{
+    _profileSinks.removeAll(sink);
+}
 
-    case Ping1DNamespace::Ack: {
-        ping_msg_ping1D_ack ackMessage{msg};
-        qCDebug(PING_PROTOCOL_PING) << "ACK message:" << ackMessage.acked_id();
-        break;
+void Ping::handleQueuedMessages()
+{
+    QueuedMessage message;
+    while(_messageQueue.pop(message)) {
+        if(message.seekIndex >= 0) {
+            handleSeek(message.packageIndex, message.seekIndex);
+            continue;
+        }
+
+        _packageIndex = message.packageIndex;
+        handleMessage(reinterpret_cast<const uint8_t*>(message.data.constData()), message.data.length(),
+                      message.timestamp);
     }
 
-    case Ping1DNamespace::Nack: {
-        ping_msg_ping1D_nack nackMessage{msg};
-        qCCritical(PING_PROTOCOL_PING) << "Sensor NACK!";
-        _nack_msg = QString("%1: %2").arg(nackMessage.nack_message()).arg(nackMessage.nacked_id());
-        qCDebug(PING_PROTOCOL_PING) << "NACK message:" << _nack_msg;
-        emit nackMsgUpdate();
+    updateProperty(_parserErrors, _frameParser->errors(), ParserErrorsProperty);
+    flushPropertyUpdates();
 
-        auto& nackRequestedId = requestedIds[static_cast<Ping1DNamespace::msg_ping1D_id>(nackMessage.nacked_id())];
-        if(nackRequestedId.waiting) {
-            nackRequestedId.waiting--;
-            nackRequestedId.nack++;
-        }
-        break;
-    }
-
-    // needs dynamic-payload patch
-    case Ping1DNamespace::Ascii_text: {
-        _ascii_text = ping_msg_ping1D_ascii_text(msg).ascii_message();
-        qCInfo(PING_PROTOCOL_PING) << "Sensor status:" << _ascii_text;
-        emit asciiTextUpdate();
-        break;
-    }
-
-    case Ping1DNamespace::Firmware_version: {
-        ping_msg_ping1D_firmware_version m(msg);
-        _device_type = m.device_type();
-        _device_model = m.device_model();
-        _firmware_version_major = m.firmware_version_major();
-        _firmware_version_minor = m.firmware_version_minor();
-
-        emit deviceTypeUpdate();
-        emit deviceModelUpdate();
-        emit firmwareVersionMajorUpdate();
-        emit firmwareVersionMinorUpdate();
-    }
-    break;
-
-    // This message is deprecated, it provides no added information because
-    // the device id is already supplied in every message header
-    case Ping1DNamespace::Device_id: {
-        ping_msg_ping1D_device_id m(msg);
-        _srcId = m.src_device_id();
-
-        emit srcIdUpdate();
-    }
-    break;
-
-    case Ping1DNamespace::Distance: {
-        ping_msg_ping1D_distance m(msg);
-        _distance = m.distance();
-        _confidence = m.confidence();
-        _pulse_duration = m.pulse_duration();
-        _ping_number = m.ping_number();
-        _scan_start = m.scan_start();
-        _scan_length = m.scan_length();
-        _gain_index = m.gain_index();
-
-        // TODO: change to distMsgUpdate() or similar
-        emit distanceUpdate();
-        emit pingNumberUpdate();
-        emit confidenceUpdate();
-        emit pulseDurationUpdate();
-        emit scanStartUpdate();
-        emit scanLengthUpdate();
-        emit gainIndexUpdate();
-    }
-    break;
-
-    case Ping1DNamespace::Distance_simple: {
-        ping_msg_ping1D_distance_simple m(msg);
-        _distance = m.distance();
-        _confidence = m.confidence();
-
-        emit distanceUpdate();
-        emit confidenceUpdate();
-    }
-    break;
-
-    case Ping1DNamespace::Profile: {
-        ping_msg_ping1D_profile m(msg);
-        _distance = m.distance();
-        _confidence = m.confidence();
-        _pulse_duration = m.pulse_duration();
-        _ping_number = m.ping_number();
-        _scan_start = m.scan_start();
-        _scan_length = m.scan_length();
-        _gain_index = m.gain_index();
-//        _num_points = m.profile_data_length(); // const for now
-//        memcpy(_points.data(), m.data(), _num_points); // careful with constant
-
-        // This is necessary to convert <uint8_t> to <int>
-        // QProperty only supports vector<int>, otherwise, we could use memcpy, like the two lines above
-        for (int i = 0; i < m.profile_data_length(); i++) {
-            _points.replace(i, m.profile_data()[i] / 255.0);
-        }
+    // Logs wait for the queue to be handled before sending more packages, fast replays do not drop messages
+    // and the UI only shows the state of the last message of each frame
+    if(link()) {
+        link()->receiverReady();
+    }
+
+    const int droppedMessages = _droppedMessages.exchange(0);
+    if(droppedMessages) {
+        qCWarning(PING_PROTOCOL_PING) << "Message queue is full," << droppedMessages << "messages were dropped.";
+    }
+}
 
-        // TODO: change to distMsgUpdate() or similar
-        emit distanceUpdate();
-        emit pingNumberUpdate();
-        emit confidenceUpdate();
-        emit pulseDurationUpdate();
-        emit scanStartUpdate();
-        emit scanLengthUpdate();
-        emit gainIndexUpdate();
-        emit pointsUpdate();
-    }
-    break;
-
-    case Ping1DNamespace::Mode_auto: {
-        ping_msg_ping1D_mode_auto m(msg);
-        if(_mode_auto != m.mode_auto()) {
-            _mode_auto = m.mode_auto();
-            emit modeAutoUpdate();
+void Ping::flushPropertyUpdates()
+{
+    static const QVector<QPair<PropertyFlag, void (Ping::*)()>> notifiers {
+        {AsciiTextProperty, &Ping::asciiTextUpdate},
+        {NackMsgProperty, &Ping::nackMsgUpdate},
+        {SrcIdProperty, &Ping::srcIdUpdate},
+        {DstIdProperty, &Ping::dstIdUpdate},
+        {DeviceTypeProperty, &Ping::deviceTypeUpdate},
+        {DeviceModelProperty, &Ping::deviceModelUpdate},
+        {FirmwareVersionMajorProperty, &Ping::firmwareVersionMajorUpdate},
+        {FirmwareVersionMinorProperty, &Ping::firmwareVersionMinorUpdate},
+        {DistanceProperty, &Ping::distanceUpdate},
+        {PingNumberProperty, &Ping::pingNumberUpdate},
+        {ConfidenceProperty, &Ping::confidenceUpdate},
+        {PulseDurationProperty, &Ping::pulseDurationUpdate},
+        {ScanStartProperty, &Ping::scanStartUpdate},
+        {ScanLengthProperty, &Ping::scanLengthUpdate},
+        {GainIndexProperty, &Ping::gainIndexUpdate},
+        {PointsProperty, &Ping::pointsUpdate},
+        {ModeAutoProperty, &Ping::modeAutoUpdate},
+        {PingIntervalProperty, &Ping::pingIntervalUpdate},
+        {SpeedOfSoundProperty, &Ping::speedOfSoundUpdate},
+        {ProcessorTemperatureProperty, &Ping::processorTemperatureUpdate},
+        {PcbTemperatureProperty, &Ping::pcbTemperatureUpdate},
+        {BoardVoltageProperty, &Ping::boardVoltageUpdate},
+        {PingEnableProperty, &Ping::pingEnableUpdate},
+        {ParserErrorsProperty, &Ping::parserErrorsUpdate},
+        {ParsedMsgsProperty, &Ping::parsedMsgsUpdate},
+        {ProfileJitterProperty, &Ping::profileJitterUpdate},
+    };
+
+    // Clear the flags before emitting, a slot can change a property again
+    const uint32_t dirtyProperties = _dirtyProperties;
+    _dirtyProperties = 0;
+    if(!dirtyProperties) {
+        return;
+    }
+
+    for(const auto& notifier : notifiers) {
+        if(dirtyProperties & notifier.first) {
+            emit (this->*notifier.second)();
         }
     }
-    break;
+}
+
+const Ping::DispatchTable& Ping::dispatchTable()
+{
+    // Built once, each entry decodes the typed message and calls its handler
+    static const DispatchTable table = [] {
+        DispatchTable table{};
+        table[Ping1DNamespace::Ack] = &Ping::dispatch<Ping1DView::Ack, &Ping::handleAck>;
+        table[Ping1DNamespace::Nack] = &Ping::dispatch<Ping1DView::Nack, &Ping::handleNack>;
+        table[Ping1DNamespace::Ascii_text] = &Ping::dispatch<Ping1DView::AsciiText, &Ping::handleAsciiText>;
+        table[Ping1DNamespace::Firmware_version] =
+            &Ping::dispatch<Ping1DView::FirmwareVersion, &Ping::handleFirmwareVersion>;
+        table[Ping1DNamespace::Device_id] = &Ping::dispatch<Ping1DView::DeviceId, &Ping::handleDeviceId>;
+        table[Ping1DNamespace::Distance] = &Ping::dispatch<Ping1DView::Distance, &Ping::handleDistance>;
+        table[Ping1DNamespace::Distance_simple] =
+            &Ping::dispatch<Ping1DView::DistanceSimple, &Ping::handleDistanceSimple>;
+        table[Ping1DNamespace::Profile] = &Ping::dispatch<Ping1DView::Profile, &Ping::handleProfile>;
+        table[Ping1DNamespace::Mode_auto] = &Ping::dispatch<Ping1DView::ModeAuto, &Ping::handleModeAuto>;
+        table[Ping1DNamespace::Ping_enable] = &Ping::dispatch<Ping1DView::PingEnable, &Ping::handlePingEnable>;
+        table[Ping1DNamespace::Ping_interval] =
+            &Ping::dispatch<Ping1DView::PingInterval, &Ping::handlePingInterval>;
+        table[Ping1DNamespace::Range] = &Ping::dispatch<Ping1DView::Range, &Ping::handleRange>;
+        table[Ping1DNamespace::General_info] = &Ping::dispatch<Ping1DView::GeneralInfo, &Ping::handleGeneralInfo>;
+        table[Ping1DNamespace::Gain_index] = &Ping::dispatch<Ping1DView::GainIndex, &Ping::handleGainIndex>;
+        table[Ping1DNamespace::Speed_of_sound] =
+            &Ping::dispatch<Ping1DView::SpeedOfSound, &Ping::handleSpeedOfSound>;
+        table[Ping1DNamespace::Processor_temperature] =
+            &Ping::dispatch<Ping1DView::ProcessorTemperature, &Ping::handleProcessorTemperature>;
+        table[Ping1DNamespace::Pcb_temperature] =
+            &Ping::dispatch<Ping1DView::PcbTemperature, &Ping::handlePcbTemperature>;
+        table[Ping1DNamespace::Voltage_5] = &Ping::dispatch<Ping1DView::Voltage5, &Ping::handleVoltage5>;
+        return table;
+    }();
+    return table;
+}
 
-    case  Ping1DNamespace::Ping_enable: {
-        ping_msg_ping1D_ping_enable m(msg);
-        _ping_enable = m.ping_enabled();
-        emit pingEnableUpdate();
+template<typename Message, void (Ping::*handler)(const Message&)>
+void Ping::dispatch(const uint8_t* data, int length)
+{
+    // Fields are read in place from the queued buffer, the message is not copied
+    const Message message(data, length);
+    if(!message.isValid()) {
+        qCWarning(PING_PROTOCOL_PING) << "Invalid payload of" << message.payload_length() << "bytes in message"
+                                      << message.message_id();
+        return;
     }
-    break;
+    (this->*handler)(message);
+}
 
-    case Ping1DNamespace::Ping_interval: {
-        ping_msg_ping1D_ping_interval m(msg);
-        _ping_interval = m.ping_interval();
-        emit pingIntervalUpdate();
+void Ping::handleMessage(const uint8_t* data, int length, qint64 timestamp)
+{
+    /*
+        Header: start1 start2 payload_length(u16) message_id(u16) src_device_id(u8) dst_device_id(u8)
+        The parser only queues complete messages with a valid checksum.
+        Handlers read the payload with the length from the header, it should be inside the message.
+    */
+    static const int headerLength = 8;
+    static const int checksumLength = 2;
+    if(!data || length < headerLength || length < headerLength + (data[2] | data[3] << 8) + checksumLength) {
+        qCWarning(PING_PROTOCOL_PING) << "Invalid message with" << length << "bytes.";
+        return;
     }
-    break;
+    const uint16_t id = data[4] | data[5] << 8;
+
+    qCDebug(PING_PROTOCOL_PING) << "Handling Message:" << id;
 
-    case Ping1DNamespace::Range: {
-        ping_msg_ping1D_range m(msg);
-        _scan_start = m.scan_start();
-        _scan_length = m.scan_length();
-        emit scanLengthUpdate();
-        emit scanStartUpdate();
+    if(timestamp < 0) {
+        timestamp = _requestScheduler.timestamp();
+    }
+    _requestScheduler.addReceivedBytes(length);
+    _requestScheduler.replied(id, timestamp, length);
+    // Packages played again after a seek arrive without the original interval
+    if(id == Ping1DNamespace::Profile && _packageIndex >= _seekIndex) {
+        updateProfileJitter(timestamp);
+    }
+    if(id < maxMessageId) {
+        auto& requestedId = requestedIds[id];
+        _firstReceipt = !requestedId.received;
+        requestedId.received = true;
+        if(requestedId.waiting) {
+            requestedId.waiting--;
+            requestedId.ack++;
+        }
     }
-    break;
 
-    case Ping1DNamespace::General_info: {
-        ping_msg_ping1D_general_info m(msg);
-        _gain_index = m.gain_index();
-        emit gainIndexUpdate();
+    const MessageHandler handler = id < maxMessageId ? dispatchTable()[id] : nullptr;
+    if(handler) {
+        (this->*handler)(data, length);
+    } else {
+        qWarning(PING_PROTOCOL_PING) << "UNHANDLED MESSAGE ID:" << id;
     }
-    break;
 
-    case Ping1DNamespace::Gain_index: {
-        ping_msg_ping1D_gain_index m(msg);
-        _gain_index = m.gain_index();
-        emit gainIndexUpdate();
+    // Notifications are only emitted once per frame, check flushPropertyUpdates
+    updateProperty(_srcId, data[6], SrcIdProperty);
+    updateProperty(_dstId, data[7], DstIdProperty);
+    _dirtyProperties |= ParsedMsgsProperty;
+    _firstReceipt = false;
+
+//    printStatus();
+}
+
+void Ping::updateProfileJitter(qint64 timestamp)
+{
+    if(_lastProfileTimestamp >= 0) {
+        const qint64 interval = (timestamp - _lastProfileTimestamp)/1000;
+        _profileIntervals.record(interval);
+
+        // Interarrival jitter from RFC 3550, the smoothing reduces the influence of a single late message
+        if(_lastProfileInterval >= 0) {
+            const float difference = qAbs(interval - _lastProfileInterval)/1000.0f;
+            updateProperty(_profileJitter, _profileJitter + (difference - _profileJitter)/16, ProfileJitterProperty);
+        }
+        _lastProfileInterval = interval;
     }
-    break;
+    _lastProfileTimestamp = timestamp;
+}
 
-    case Ping1DNamespace::Speed_of_sound: {
-        ping_msg_ping1D_speed_of_sound m(msg);
-        _speed_of_sound = m.speed_of_sound();
-        emit speedOfSoundUpdate();
+void Ping::handleAck(const Ping1DView::Ack& m)
+{
+    qCDebug(PING_PROTOCOL_PING) << "ACK message:" << m.acked_id();
+}
+
+void Ping::handleNack(const Ping1DView::Nack& m)
+{
+    qCCritical(PING_PROTOCOL_PING) << "Sensor NACK!";
+    // Each NACK is notified, even if it's the same as the last one
+    _nack_msg = QString("%1: %2").arg(m.nack_message()).arg(m.nacked_id());
+    _dirtyProperties |= NackMsgProperty;
+    qCDebug(PING_PROTOCOL_PING) << "NACK message:" << _nack_msg;
+
+    _requestScheduler.replied(m.nacked_id());
+    if(m.nacked_id() < maxMessageId) {
+        auto& nackRequestedId = requestedIds[m.nacked_id()];
+        if(nackRequestedId.waiting) {
+            nackRequestedId.waiting--;
+            nackRequestedId.nack++;
+        }
     }
-    break;
+}
+
+// needs dynamic-payload patch
+void Ping::handleAsciiText(const Ping1DView::AsciiText& m)
+{
+    // Each text is notified, even if it's the same as the last one
+    _ascii_text = m.ascii_message();
+    _dirtyProperties |= AsciiTextProperty;
+    qCInfo(PING_PROTOCOL_PING) << "Sensor status:" << _ascii_text;
+}
+
+void Ping::handleFirmwareVersion(const Ping1DView::FirmwareVersion& m)
+{
+    updateProperty(_device_type, m.device_type(), DeviceTypeProperty);
+    updateProperty(_device_model, m.device_model(), DeviceModelProperty);
+    updateProperty(_firmware_version_major, m.firmware_version_major(), FirmwareVersionMajorProperty);
+    updateProperty(_firmware_version_minor, m.firmware_version_minor(), FirmwareVersionMinorProperty);
+}
+
+// This message is deprecated, it provides no added information because
+// the device id is already supplied in every message header
+void Ping::handleDeviceId(const Ping1DView::DeviceId& m)
+{
+    updateProperty(_srcId, m.src_device_id(), SrcIdProperty);
+}
 
-    case Ping1DNamespace::Processor_temperature: {
-        ping_msg_ping1D_processor_temperature m(msg);
-        _processor_temperature = m.processor_temperature();
-        emit processorTemperatureUpdate();
+void Ping::handleDistance(const Ping1DView::Distance& m)
+{
+    updateProperty(_distance, m.distance(), DistanceProperty);
+    updateProperty(_confidence, m.confidence(), ConfidenceProperty);
+    updateProperty(_pulse_duration, m.pulse_duration(), PulseDurationProperty);
+    updateProperty(_ping_number, m.ping_number(), PingNumberProperty);
+    updateProperty(_scan_start, m.scan_start(), ScanStartProperty);
+    updateProperty(_scan_length, m.scan_length(), ScanLengthProperty);
+    updateProperty(_gain_index, m.gain_index(), GainIndexProperty);
+}
+
+void Ping::handleDistanceSimple(const Ping1DView::DistanceSimple& m)
+{
+    updateProperty(_distance, m.distance(), DistanceProperty);
+    updateProperty(_confidence, m.confidence(), ConfidenceProperty);
+}
+
+void Ping::handleProfile(const Ping1DView::Profile& m)
+{
+    updateProperty(_distance, m.distance(), DistanceProperty);
+    updateProperty(_confidence, m.confidence(), ConfidenceProperty);
+    updateProperty(_pulse_duration, m.pulse_duration(), PulseDurationProperty);
+    updateProperty(_ping_number, m.ping_number(), PingNumberProperty);
+    updateProperty(_scan_start, m.scan_start(), ScanStartProperty);
+    updateProperty(_scan_length, m.scan_length(), ScanLengthProperty);
+    updateProperty(_gain_index, m.gain_index(), GainIndexProperty);
+
+    // Samples are kept as raw bytes, the array is shared with the profile sent to the sinks
+    // The profile length comes from the message, buffers are reused when all sinks release them
+    _points = _profileBuffers.copy(m.profile_data(), m.profile_data_length());
+    _dirtyProperties |= PointsProperty;
+
+    // Every profile goes to the sinks, the same immutable profile is shared between all of them
+    const Profile::Pointer profile(new Profile(_points, _confidence, _scan_start*1e-3, _scan_length*1e-3,
+                                   _distance*1e-3));
+    for(const auto& object : qAsConst(_profileSinks)) {
+        if(auto sink = qobject_cast<ProfileSink*>(object.data())) {
+            sink->appendProfile(profile);
+        }
     }
-    break;
 
-    case Ping1DNamespace::Pcb_temperature: {
-        ping_msg_ping1D_pcb_temperature m(msg);
-        _pcb_temperature = m.pcb_temperature();
-        emit pcbTemperatureUpdate();
+    if(_packageIndex >= 0 && ++_profilesSinceKeyframe >= _keyframeSpacing) {
+        saveKeyframe();
     }
-    break;
+}
 
-    case Ping1DNamespace::Voltage_5: {
-        ping_msg_ping1D_voltage_5 m(msg);
-        _board_voltage = m.voltage_5(); // millivolts
-        emit boardVoltageUpdate();
+void Ping::saveKeyframe()
+{
+    _profilesSinceKeyframe = 0;
+    _keyframes.insert(_packageIndex, {
+        _srcId, _device_type, _device_model, _firmware_version_major, _firmware_version_minor,
+        _distance, _confidence, _pulse_duration, _ping_number, _scan_start, _scan_length, _gain_index,
+        _speed_of_sound, _processor_temperature, _pcb_temperature, _board_voltage, _ping_enable,
+        _mode_auto, _ping_interval, _points
+    });
+
+    // Keyframes stay spread over the whole log, the ones after this point are saved with a bigger spacing
+    if(_keyframes.size() > _maxKeyframes) {
+        bool remove = false;
+        for(auto keyframe = _keyframes.begin(); keyframe != _keyframes.end(); remove = !remove) {
+            keyframe = remove ? _keyframes.erase(keyframe) : std::next(keyframe);
+        }
+        _keyframeSpacing *= 2;
     }
-    break;
+}
 
-    default:
-        qWarning(PING_PROTOCOL_PING) << "UNHANDLED MESSAGE ID:" << msg.message_id();
-        break;
+bool Ping::restoreKeyframe(int packageIndex)
+{
+    // Keyframes are saved after handling their package, the package itself is played again
+    auto keyframe = _keyframes.lowerBound(packageIndex);
+    if(keyframe == _keyframes.begin()) {
+        return false;
     }
+    --keyframe;
+
+    updateProperty(_srcId, keyframe->srcId, SrcIdProperty);
+    updateProperty(_device_type, keyframe->deviceType, DeviceTypeProperty);
+    updateProperty(_device_model, keyframe->deviceModel, DeviceModelProperty);
+    updateProperty(_firmware_version_major, keyframe->firmwareVersionMajor, FirmwareVersionMajorProperty);
+    updateProperty(_firmware_version_minor, keyframe->firmwareVersionMinor, FirmwareVersionMinorProperty);
+    updateProperty(_distance, keyframe->distance, DistanceProperty);
+    updateProperty(_confidence, keyframe->confidence, ConfidenceProperty);
+    updateProperty(_pulse_duration, keyframe->pulseDuration, PulseDurationProperty);
+    updateProperty(_ping_number, keyframe->pingNumber, PingNumberProperty);
+    updateProperty(_scan_start, keyframe->scanStart, ScanStartProperty);
+    updateProperty(_scan_length, keyframe->scanLength, ScanLengthProperty);
+    updateProperty(_gain_index, keyframe->gainIndex, GainIndexProperty);
+    updateProperty(_speed_of_sound, keyframe->speedOfSound, SpeedOfSoundProperty);
+    updateProperty(_processor_temperature, keyframe->processorTemperature, ProcessorTemperatureProperty);
+    updateProperty(_pcb_temperature, keyframe->pcbTemperature, PcbTemperatureProperty);
+    updateProperty(_board_voltage, keyframe->boardVoltage, BoardVoltageProperty);
+    updateProperty(_ping_enable, keyframe->pingEnable, PingEnableProperty);
+    updateProperty(_mode_auto, keyframe->modeAuto, ModeAutoProperty);
+    updateProperty(_ping_interval, keyframe->pingInterval, PingIntervalProperty);
+    _points = keyframe->points;
+    _dirtyProperties |= PointsProperty;
+    return true;
+}
 
-    // TODO: is this signalling expensive?
-    // we can cut down on this a lot in general
-    _dstId = msg.dst_device_id();
-    _srcId = msg.src_device_id();
+void Ping::handleSeek(int preRollIndex, int index)
+{
+    qCDebug(PING_PROTOCOL_PING) << "Log seek to package" << index << "from package" << preRollIndex;
 
-    emit dstIdUpdate();
-    emit srcIdUpdate();
-    emit parsedMsgsUpdate();
+    // Profiles before the seek are from another part of the log, the pre-roll packages rebuild them
+    for(const auto& object : qAsConst(_profileSinks)) {
+        if(auto sink = qobject_cast<ProfileSink*>(object.data())) {
+            sink->clearProfiles();
+        }
+    }
 
-//    printStatus();
+    restoreKeyframe(preRollIndex);
+    _seekIndex = index;
+    _profilesSinceKeyframe = 0;
+    _lastProfileTimestamp = -1;
+    _lastProfileInterval = -1;
+}
+
+void Ping::handleModeAuto(const Ping1DView::ModeAuto& m)
+{
+    updateProperty(_mode_auto, m.mode_auto(), ModeAutoProperty);
+}
+
+void Ping::handlePingEnable(const Ping1DView::PingEnable& m)
+{
+    updateProperty(_ping_enable, m.ping_enabled(), PingEnableProperty);
+}
+
+void Ping::handlePingInterval(const Ping1DView::PingInterval& m)
+{
+    updateProperty(_ping_interval, m.ping_interval(), PingIntervalProperty);
+}
+
+void Ping::handleRange(const Ping1DView::Range& m)
+{
+    updateProperty(_scan_start, m.scan_start(), ScanStartProperty);
+    updateProperty(_scan_length, m.scan_length(), ScanLengthProperty);
+}
+
+void Ping::handleGeneralInfo(const Ping1DView::GeneralInfo& m)
+{
+    updateProperty(_gain_index, m.gain_index(), GainIndexProperty);
+}
+
+void Ping::handleGainIndex(const Ping1DView::GainIndex& m)
+{
+    updateProperty(_gain_index, m.gain_index(), GainIndexProperty);
+}
+
+void Ping::handleSpeedOfSound(const Ping1DView::SpeedOfSound& m)
+{
+    updateProperty(_speed_of_sound, m.speed_of_sound(), SpeedOfSoundProperty);
+}
+
+void Ping::handleProcessorTemperature(const Ping1DView::ProcessorTemperature& m)
+{
+    updateProperty(_processor_temperature, m.processor_temperature(), ProcessorTemperatureProperty);
+}
+
+void Ping::handlePcbTemperature(const Ping1DView::PcbTemperature& m)
+{
+    updateProperty(_pcb_temperature, m.pcb_temperature(), PcbTemperatureProperty);
+}
+
+void Ping::handleVoltage5(const Ping1DView::Voltage5& m)
+{
+    updateProperty(_board_voltage, m.voltage_5(), BoardVoltageProperty); // millivolts
 }
 
 void Ping::firmwareUpdate(QString fileUrl, bool sendPingGotoBootloader, int baud, bool verify)
@@ -420,21 +675,23 @@ void Ping::firmwareUpdate(QString fileUrl, bool sendPingGotoBootloader, int baud
     if (sendPingGotoBootloader) {
         qCDebug(PING_PROTOCOL_PING) << "Put it in bootloader mode.";
         ping_msg_ping1D_goto_bootloader m;
-        m.updateChecksum();
         writeMessage(m);
     }
 
     // Wait for bytes to be written before finishing the connection
-    while (serialLink->port()->bytesToWrite()) {
-        qCDebug(PING_PROTOCOL_PING) << "Waiting for bytes to be written...";
-        serialLink->port()->waitForBytesWritten();
-        qCDebug(PING_PROTOCOL_PING) << "Done !";
-    }
+    // The port lives in the I/O thread, where the queued message will be written
+    runInLinkThread([serialLink] {
+        while (serialLink->port()->bytesToWrite()) {
+            qCDebug(PING_PROTOCOL_PING) << "Waiting for bytes to be written...";
+            serialLink->port()->waitForBytesWritten();
+            qCDebug(PING_PROTOCOL_PING) << "Done !";
+        }
+    });
 
     qCDebug(PING_PROTOCOL_PING) << "Finish connection.";
     // TODO: Move thread delay to something more.. correct.
     QThread::msleep(500);
-    link()->finishConnection();
+    runInLinkThread([this] { link()->finishConnection(); });
 
 
     QSerialPortInfo pInfo(serialLink->port()->portName());
@@ -515,21 +772,72 @@ void Ping::firmwareUpdatePercentage()
     qCDebug(PING_PROTOCOL_PING) << output;
 }
 
-void Ping::request(int id)
+void Ping::request(int id, RequestScheduler::Priority priority)
 {
     if(!link()->isWritable()) {
         qCWarning(PING_PROTOCOL_PING) << "Can't write in this type of link.";
         return;
     }
+
+    _requestScheduler.request(id, priority);
+}
+
+bool Ping::dumpLatencyStatistics(const QString& fileName)
+{
+    const QString path = fileName.isEmpty() ? FileManager::self()->createFileName(FileManager::GuiLogs) : fileName;
+    QFile file(path);
+    if(!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
+        qCWarning(PING_PROTOCOL_PING) << "Failed to write latency statistics in" << path << file.errorString();
+        return false;
+    }
+
+    // Values are written in milliseconds
+    QTextStream stream(&file);
+    stream << "# Request latency (ms)\n";
+    stream << "# id requests replies retries timeouts min p50 p90 p99 p99.9 max\n";
+    auto ids = _requestScheduler.requestedIds();
+    std::sort(ids.begin(), ids.end());
+    for(const int id : ids) {
+        const auto statistics = _requestScheduler.statistics(id);
+        const auto& latency = statistics.latency;
+        stream << id << " " << statistics.requests << " " << statistics.replies << " " << statistics.retries
+               << " " << statistics.timeouts << " " << latency.min()/1000.0
+               << " " << latency.valueAtPercentile(50)/1000.0 << " " << latency.valueAtPercentile(90)/1000.0
+               << " " << latency.valueAtPercentile(99)/1000.0 << " " << latency.valueAtPercentile(99.9)/1000.0
+               << " " << latency.max()/1000.0 << "\n";
+    }
+
+    stream << "\n# Profile interval (ms)\n";
+    stream << "# count mean p50 p99 max jitter\n";
+    stream << _profileIntervals.count() << " " << _profileIntervals.mean()/1000.0
+           << " " << _profileIntervals.valueAtPercentile(50)/1000.0
+           << " " << _profileIntervals.valueAtPercentile(99)/1000.0
+           << " " << _profileIntervals.max()/1000.0 << " " << _profileJitter << "\n";
+
+    // Full distributions, one line for each used bucket
+    for(const int id : ids) {
+        stream << "\n# Request latency distribution of id " << id << " (value percentile count)\n";
+        _requestScheduler.statistics(id).latency.writeDistribution(stream, 1000);
+    }
+    stream << "\n# Profile interval distribution (value percentile count)\n";
+    _profileIntervals.writeDistribution(stream, 1000);
+
+    qCDebug(PING_PROTOCOL_PING) << "Latency statistics saved in" << path;
+    return stream.status() == QTextStream::Ok;
+}
+
+void Ping::sendRequest(int id)
+{
     qCDebug(PING_PROTOCOL_PING) << "Requesting:" << id;
 
     ping_msg_ping1D_empty m;
     m.set_id(id);
-    m.updateChecksum();
     writeMessage(m);
 
-    // Add requested id
-    requestedIds[static_cast<Ping1DNamespace::msg_ping1D_id>(id)].waiting++;
+    // The scheduler has a single request of each id, a retry does not add another reply to wait for
+    if(id >= 0 && id < maxMessageId) {
+        requestedIds[id].waiting = 1;
+    }
 }
 
 void Ping::setLastPingConfiguration()
@@ -620,11 +928,16 @@ void Ping::printStatus()
     qCDebug(PING_PROTOCOL_PING) << "\t- gain_index:" << _gain_index;
     qCDebug(PING_PROTOCOL_PING) << "\t- mode_auto:" << _mode_auto;
     qCDebug(PING_PROTOCOL_PING) << "\t- ping_interval:" << _ping_interval;
-    qCDebug(PING_PROTOCOL_PING) << "\t- points:" << QByteArray((const char*)_points.data(), _num_points).toHex(',');
+    qCDebug(PING_PROTOCOL_PING) << "\t- points:" << _points.toHex(',');
+    qCDebug(PING_PROTOCOL_PING) << "\t- link usage:" << _requestScheduler.linkUsage();
+    for(const int id : _requestScheduler.requestedIds()) {
+        qCDebug(PING_PROTOCOL_PING) << "\t- request" << id << _requestScheduler.statistics(id);
+    }
 }
 
-void Ping::writeMessage(const PingMessage &msg)
+void Ping::writeMessage(PingMessage &msg)
 {
+    PingFrameParser::updateChecksum(msg.msgData, msg.msgDataLength());
     if(link() && link()->isOpen() && link()->isWritable()) {
         link()->write(reinterpret_cast<const char*>(msg.msgData), msg.msgDataLength());
     }
@@ -694,10 +1007,22 @@ void Ping::resetSensorLocalVariables()
 
 Ping::~Ping()
 {
-    updatePingConfigurationSettings();
+    if(_detect) {
+        updatePingConfigurationSettings();
+    }
+
+    // The frame handler and the seek marker push to the message queue from the I/O thread, they are stopped in that
+    // thread so no push is running when the queue is destroyed
+    runInLinkThread([this] {
+        _frameParser->setFrameHandler(nullptr);
+        if(link()) {
+            disconnect(link(), &AbstractLink::seeked, this, nullptr);
+        }
+    });
 }
 
 QDebug operator<<(QDebug d, const Ping::messageStatus& other)
 {
-    return d << "waiting: " << other.waiting << ", ack: " << other.ack << ", nack: " << other.nack;
+    return d << "received: " << other.received << ", waiting: " << other.waiting << ", ack: " << other.ack
+           << ", nack: " << other.nack;
 }
@@ -1,16 +1,25 @@
 #pragma once
 
+#include <array>
+#include <atomic>
 #include <functional>
 
+#include <QMap>
+#include <QPointer>
 #include <QProcess>
 #include <QSharedPointer>
 #include <QTimer>
 
-#include "parsers/parser.h"
-#include "parsers/parser_ping.h"
+#include "bufferpool.h"
+#include "latencyhistogram.h"
+#include "pingframeparser.h"
+#include "pingmessageview.h"
 #include "pingmessage/pingmessage_all.h"
+#include "profilesink.h"
 #include "protocoldetector.h"
+#include "requestscheduler.h"
 #include "sensor.h"
+#include "spscqueue.h"
 
 /**
  * @brief Define ping sensor
@@ -22,7 +31,13 @@ class Ping : public Sensor
     Q_OBJECT
 public:
 
-    Ping();
+    /**
+     * @brief Construct a new Ping object
+     *
+     * @param detect Load the last connection from the settings and start the detector.
+     *  Without it no port is probed and the settings are not changed, messages and logs can be handled offline
+     */
+    explicit Ping(bool detect = true);
     ~Ping();
 
     /**
@@ -40,6 +55,21 @@ public:
      */
     Q_INVOKABLE void connectLink(AbstractLinkNamespace::LinkType connType, const QStringList& connString);
 
+    /**
+     * @brief Register an object that receives every profile
+     *  Profiles are sent directly from C++, pointsUpdate is only emitted once per frame with the latest profile
+     *
+     * @param sink QObject that implements ProfileSink
+     */
+    Q_INVOKABLE void addProfileSink(QObject* sink);
+
+    /**
+     * @brief Stop sending profiles to a sink
+     *
+     * @param sink
+     */
+    Q_INVOKABLE void removeProfileSink(QObject* sink);
+
     /**
      * @brief debug function
      */
@@ -78,7 +108,6 @@ public:
     {
         ping_msg_ping1D_set_ping_enable m;
         m.set_ping_enabled(enabled);
-        m.updateChecksum();
         writeMessage(m);
         request(Ping1DNamespace::Ping_enable);
     }
@@ -166,7 +195,6 @@ public:
         ping_msg_ping1D_set_range m;
         m.set_scan_start(start_mm);
         m.set_scan_length(_scan_length);
-        m.updateChecksum();
         writeMessage(m);
         request(Ping1DNamespace::Range);
     }
@@ -189,7 +217,6 @@ public:
         ping_msg_ping1D_set_range m;
         m.set_scan_start(_scan_start);
         m.set_scan_length(length_mm);
-        m.updateChecksum();
         writeMessage(m);
         request(Ping1DNamespace::Range);
     }
@@ -211,7 +238,6 @@ public:
     {
         ping_msg_ping1D_set_gain_index m;
         m.set_gain_index(gain_index);
-        m.updateChecksum();
         writeMessage(m);
         request(Ping1DNamespace::Gain_index);
     }
@@ -219,11 +245,12 @@ public:
 
     /**
      * @brief Return last array of points
+     *  Raw intensity (0-255) of each sample, the data is shared with the last profile
      *
-     * @return QVector<double>
+     * @return QByteArray
      */
-    QVector<double> points() { return _points; }
-    Q_PROPERTY(QVector<double> points READ points NOTIFY pointsUpdate)
+    QByteArray points() { return _points; }
+    Q_PROPERTY(QByteArray points READ points NOTIFY pointsUpdate)
 
     /**
      * @brief Get auto mode status
@@ -242,7 +269,6 @@ public:
     {
         ping_msg_ping1D_set_mode_auto m;
         m.set_mode_auto(mode_auto);
-        m.updateChecksum();
         writeMessage(m);
         request(Ping1DNamespace::Mode_auto);
     }
@@ -257,7 +283,6 @@ public:
     {
         ping_msg_ping1D_continuous_start m;
         m.set_id(static_cast<int>(id));
-        m.updateChecksum();
         writeMessage(m);
     }
 
@@ -270,7 +295,6 @@ public:
     {
         ping_msg_ping1D_continuous_stop m;
         m.set_id(static_cast<int>(id));
-        m.updateChecksum();
         writeMessage(m);
     }
 
@@ -290,7 +314,6 @@ public:
     {
         ping_msg_ping1D_set_ping_interval m;
         m.set_ping_interval(ping_interval);
-        m.updateChecksum();
         writeMessage(m);
         request(Ping1DNamespace::Ping_interval);
     }
@@ -312,7 +335,6 @@ public:
     {
         ping_msg_ping1D_set_speed_of_sound m;
         m.set_speed_of_sound(speed_of_sound);
-        m.updateChecksum();
         writeMessage(m);
         request(Ping1DNamespace::Speed_of_sound);
     }
@@ -385,7 +407,7 @@ public:
      *
      * @return int
      */
-    int parserErrors() { return _parser ? _parser->errors : 0; }
+    int parserErrors() { return _parserErrors; }
     Q_PROPERTY(int parser_errors READ parserErrors NOTIFY parserErrorsUpdate)
 
     /**
@@ -393,7 +415,7 @@ public:
      *
      * @return int
      */
-    int parsedMsgs() { return _parser ? _parser->parsed : 0; }
+    int parsedMsgs() { return _frameParser->parsed(); }
     Q_PROPERTY(int parsed_msgs READ parsedMsgs NOTIFY parsedMsgsUpdate)
     // TODO: maybe store history/filtered history of values in this
     // object for access by different visual elements without need to recompute
@@ -407,12 +429,38 @@ public:
     int lostMessages() { return _lostMessages; }
     Q_PROPERTY(int lost_messages READ lostMessages NOTIFY lostMessagesUpdate)
 
+    /**
+     * @brief Return the inter-arrival jitter of profile messages
+     *  Smoothed difference between consecutive profile intervals (RFC 3550), in milliseconds
+     *
+     * @return float
+     */
+    float profileJitter() { return _profileJitter; }
+    Q_PROPERTY(float profile_jitter READ profileJitter NOTIFY profileJitterUpdate)
+
     /**
      * @brief Request message id
      *
      * @param id
      */
-    Q_INVOKABLE void request(int id);
+    Q_INVOKABLE void request(int id) { request(id, RequestScheduler::Configuration); };
+
+    /**
+     * @brief Request message id with a specific priority
+     *  Requests are sent by the request scheduler, check RequestScheduler
+     *
+     * @param id
+     * @param priority
+     */
+    void request(int id, RequestScheduler::Priority priority);
+
+    /**
+     * @brief Write request latency and profile interval histograms to a text file
+     *
+     * @param fileName if empty, a new file is created in the GUI log folder
+     * @return true if the file was written
+     */
+    Q_INVOKABLE bool dumpLatencyStatistics(const QString& fileName = QString());
 
     /**
      * @brief Do firmware sensor update
@@ -461,6 +509,8 @@ signals:
 
     void parserErrorsUpdate();
     void parsedMsgsUpdate();
+
+    void profileJitterUpdate();
 ///@}
 
     /**
@@ -517,20 +567,252 @@ private:
 
     float _fw_update_perc;
 
-    static const uint16_t _num_points = 200;
-
-    // TODO: maybe use vector or uint8_t[] here
-    // QVector is only required if points need to be exposed to qml
-    //QVector<int> _points;
-    QVector<double> _points;
+    // Raw samples of the last profile
+    QByteArray _points;
+    // Reusable profile buffers for each profile length
+    BufferPool _profileBuffers;
 
     bool _mode_auto = 0;
     uint16_t _ping_interval = 0;
     static const int _pingMaxFrequency;
 
-    // TODO: const &
-    void handleMessage(PingMessage msg); // handle incoming message
-    void writeMessage(const PingMessage& msg); // write a message to link
+    /**
+     * @brief Handle a complete message, check dispatchTable
+     *
+     * @param data message buffer, including header and checksum
+     * @param length number of bytes
+     * @param timestamp time when the message was received, from the request scheduler clock, -1 to use the current
+     *  time
+     */
+    void handleMessage(const uint8_t* data, int length, qint64 timestamp = -1);
+
+    /**
+     * @brief Update profile interval histogram and jitter with a new profile message
+     *
+     * @param timestamp time when the profile was received, in nanoseconds
+     */
+    void updateProfileJitter(qint64 timestamp);
+
+    // Message ids are small integers, they are used directly as index of flat arrays
+    static const int maxMessageId = 2048;
+
+    typedef void (Ping::*MessageHandler)(const uint8_t* data, int length);
+    typedef std::array<MessageHandler, maxMessageId> DispatchTable;
+
+    /**
+     * @brief Return the handler of each message id, nullptr for unhandled messages
+     *
+     * @return const DispatchTable&
+     */
+    static const DispatchTable& dispatchTable();
+
+    /**
+     * @brief Decode a message with its type and call the handler
+     *  Messages with fields outside the payload are dropped
+     *
+     * @tparam Message message view type
+     * @tparam handler
+     * @param data
+     * @param length
+     */
+    template<typename Message, void (Ping::*handler)(const Message&)>
+    void dispatch(const uint8_t* data, int length);
+
+    /**
+     * @brief Message handlers
+     *
+     */
+    ///@{
+    void handleAck(const Ping1DView::Ack& m);
+    void handleNack(const Ping1DView::Nack& m);
+    void handleAsciiText(const Ping1DView::AsciiText& m);
+    void handleFirmwareVersion(const Ping1DView::FirmwareVersion& m);
+    void handleDeviceId(const Ping1DView::DeviceId& m);
+    void handleDistance(const Ping1DView::Distance& m);
+    void handleDistanceSimple(const Ping1DView::DistanceSimple& m);
+    void handleProfile(const Ping1DView::Profile& m);
+    void handleModeAuto(const Ping1DView::ModeAuto& m);
+    void handlePingEnable(const Ping1DView::PingEnable& m);
+    void handlePingInterval(const Ping1DView::PingInterval& m);
+    void handleRange(const Ping1DView::Range& m);
+    void handleGeneralInfo(const Ping1DView::GeneralInfo& m);
+    void handleGainIndex(const Ping1DView::GainIndex& m);
+    void handleSpeedOfSound(const Ping1DView::SpeedOfSound& m);
+    void handleProcessorTemperature(const Ping1DView::ProcessorTemperature& m);
+    void handlePcbTemperature(const Ping1DView::PcbTemperature& m);
+    void handleVoltage5(const Ping1DView::Voltage5& m);
+    ///@}
+
+    /**
+     * @brief Handle all messages decoded by the I/O thread since the last call
+     *
+     */
+    void handleQueuedMessages();
+
+    // The sensor was created with detect, it uses the user settings and the network
+    const bool _detect;
+
+    // Finds messages in the received data, lives in the I/O thread
+    PingFrameParser* _frameParser;
+    // Parser errors when the message queue was last handled
+    int _parserErrors = 0;
+    // Raw messages decoded in the I/O thread, waiting to be handled in the GUI thread
+    // The receive time is taken in the I/O thread, so the queue delay is not part of the measured latency
+    struct QueuedMessage {
+        QByteArray data;
+        qint64 timestamp = 0;
+        // Log package of the message, -1 for links that can't seek
+        int packageIndex = -1;
+        // Seek markers have no data, the next messages are from packageIndex up to this package
+        int seekIndex = -1;
+    };
+    SpscQueue<QueuedMessage> _messageQueue{1024};
+    // Messages dropped because the GUI thread did not drain the queue in time
+    std::atomic<int> _droppedMessages{0};
+    // Drain the message queue once per frame
+    QTimer _messageQueueTimer;
+
+    // Objects that implement ProfileSink, they are removed automatically when destroyed
+    QVector<QPointer<QObject>> _profileSinks;
+
+    // Log that sends the messages, the package index is read in the I/O thread while the package is parsed
+    std::atomic<AbstractLink*> _logLink{nullptr};
+    // Log package of the message being handled
+    int _packageIndex = -1;
+    // Messages before this package are played again after a seek
+    int _seekIndex = -1;
+
+    /**
+     * @brief Sensor state saved while a log is played
+     *  Seeking restores the last keyframe before the packages that are played again, this recovers values that
+     *  are only sent when the sensor is configured (E.g: firmware version and speed of sound).
+     *
+     */
+    struct Keyframe {
+        uint8_t srcId;
+        uint8_t deviceType;
+        uint8_t deviceModel;
+        uint16_t firmwareVersionMajor;
+        uint16_t firmwareVersionMinor;
+        uint32_t distance;
+        uint8_t confidence;
+        uint16_t pulseDuration;
+        uint32_t pingNumber;
+        uint32_t scanStart;
+        uint32_t scanLength;
+        uint32_t gainIndex;
+        uint32_t speedOfSound;
+        uint16_t processorTemperature;
+        uint16_t pcbTemperature;
+        uint16_t boardVoltage;
+        bool pingEnable;
+        bool modeAuto;
+        uint16_t pingInterval;
+        QByteArray points;
+    };
+    // Keyframes by log package index
+    QMap<int, Keyframe> _keyframes;
+    // Number of profiles between keyframes
+    static const int _keyframeInterval;
+    // Keyframes kept for a log, every other keyframe is removed when there are more
+    static const int _maxKeyframes;
+    // Current number of profiles between keyframes, it doubles each time the keyframes are thinned
+    int _keyframeSpacing = _keyframeInterval;
+    int _profilesSinceKeyframe = 0;
+
+    /**
+     * @brief Save the sensor state in a keyframe of the current log package
+     *  Keyframes are thinned when there are more than _maxKeyframes, so long logs use bounded memory
+     *
+     */
+    void saveKeyframe();
+
+    /**
+     * @brief Restore the last keyframe before a log package
+     *
+     * @param packageIndex
+     * @return true
+     * @return false if there is no keyframe before it
+     */
+    bool restoreKeyframe(int packageIndex);
+
+    /**
+     * @brief Handle a log seek, the sinks are cleared and the state is restored from a keyframe
+     *  The link sends the packages from preRollIndex again, they rebuild the profile history
+     *
+     * @param preRollIndex
+     * @param index
+     */
+    void handleSeek(int preRollIndex, int index);
+
+    /**
+     * @brief Properties with a pending change notification
+     *  handleMessage only flags the properties that changed, the signals are emitted once per frame
+     *  by flushPropertyUpdates. This avoids QML bindings being evaluated for every message.
+     */
+    enum PropertyFlag : uint32_t {
+        AsciiTextProperty = 1u << 0,
+        NackMsgProperty = 1u << 1,
+        SrcIdProperty = 1u << 2,
+        DstIdProperty = 1u << 3,
+        DeviceTypeProperty = 1u << 4,
+        DeviceModelProperty = 1u << 5,
+        FirmwareVersionMajorProperty = 1u << 6,
+        FirmwareVersionMinorProperty = 1u << 7,
+        DistanceProperty = 1u << 8,
+        PingNumberProperty = 1u << 9,
+        ConfidenceProperty = 1u << 10,
+        PulseDurationProperty = 1u << 11,
+        ScanStartProperty = 1u << 12,
+        ScanLengthProperty = 1u << 13,
+        GainIndexProperty = 1u << 14,
+        PointsProperty = 1u << 15,
+        ModeAutoProperty = 1u << 16,
+        PingIntervalProperty = 1u << 17,
+        SpeedOfSoundProperty = 1u << 18,
+        ProcessorTemperatureProperty = 1u << 19,
+        PcbTemperatureProperty = 1u << 20,
+        BoardVoltageProperty = 1u << 21,
+        PingEnableProperty = 1u << 22,
+        ParserErrorsProperty = 1u << 23,
+        ParsedMsgsProperty = 1u << 24,
+        ProfileJitterProperty = 1u << 25,
+    };
+    uint32_t _dirtyProperties = 0;
+    // Set while the first message of an id is handled, its values are notified even if they are the defaults
+    bool _firstReceipt = false;
+
+    /**
+     * @brief Set a property and flag it if the value changed or if it's the first message with it
+     *
+     * @param property
+     * @param value
+     * @param flag
+     */
+    template<typename T, typename V>
+    void updateProperty(T& property, const V& value, PropertyFlag flag)
+    {
+        const T newValue(value);
+        if(property != newValue || _firstReceipt) {
+            property = newValue;
+            _dirtyProperties |= flag;
+        }
+    }
+
+    /**
+     * @brief Emit the change signal of all flagged properties
+     *
+     */
+    void flushPropertyUpdates();
+
+    void writeMessage(PingMessage& msg); // update checksum and write a message to link
+
+    /**
+     * @brief Write a request message, called by the request scheduler
+     *
+     * @param id
+     */
+    void sendRequest(int id);
 
     static const QString stm32flashPath();
     void firmwareUpdatePercentage();
@@ -574,6 +856,15 @@ private:
     // For automatic periodic updates (board voltage and temperature)
     QTimer _periodicRequestTimer;
 
+    // Limit and prioritize requests to not burst slow links
+    RequestScheduler _requestScheduler;
+
+    // Time between profile messages in microseconds
+    LatencyHistogram _profileIntervals;
+    qint64 _lastProfileTimestamp = -1;
+    qint64 _lastProfileInterval = -1;
+    float _profileJitter = 0;
+
     QSharedPointer<QProcess> _firmwareProcess;
 
     struct settingsConfiguration {
@@ -649,6 +940,8 @@ private:
     int _lostMessages = 0;
 
     struct messageStatus {
+        // Received since the link was connected, requested or not
+        bool received = false;
         // Requested and acknowledge
         int ack = 0;
         // Requested and not acknowledge
@@ -657,5 +950,6 @@ private:
         int waiting = 0;
     };
     friend QDebug operator<<(QDebug d, const Ping::messageStatus& other);
-    QHash<Ping1DNamespace::msg_ping1D_id, messageStatus> requestedIds;
+    // Indexed by message id
+    std::array<messageStatus, maxMessageId> requestedIds;
 };
@@ -0,0 +1,159 @@
+#include <cstring>
+
+#include "checksum.h"
+#include "pingframeparser.h"
+
+namespace
+{
+/**
+ * @brief Return the frame length of a complete header
+ *
+ */
+int frameLength(const uint8_t* header)
+{
+    const int payloadLength = header[2] | header[3] << 8;
+    return PingFrameParser::headerLength + payloadLength + PingFrameParser::checksumLength;
+}
+
+/**
+ * @brief Check if the frame length claimed by a complete header is valid
+ *
+ */
+bool validHeader(const uint8_t* header)
+{
+    return (header[2] | header[3] << 8) <= PingFrameParser::maxPayloadLength;
+}
+}
+
+PingFrameParser::PingFrameParser(const FrameHandler& handler)
+    : _handler(handler)
+{
+}
+
+uint16_t PingFrameParser::checksum(const uint8_t* data, int length)
+{
+    return Checksum::sum(data, length - checksumLength);
+}
+
+void PingFrameParser::updateChecksum(uint8_t* data, int length)
+{
+    if(!data || length < headerLength + checksumLength) {
+        return;
+    }
+
+    const uint16_t sum = checksum(data, length);
+    data[length - 2] = sum & 0xff;
+    data[length - 1] = sum >> 8;
+}
+
+int PingFrameParser::parse(const uint8_t* data, int length)
+{
+    if(!data || length <= 0) {
+        return 0;
+    }
+
+    int frames = 0;
+    int position = 0;
+    while(!_pending.isEmpty() && position < length) {
+        position += completePending(data + position, length - position, frames);
+    }
+
+    return frames + scan(data + position, length - position);
+}
+
+int PingFrameParser::completePending(const uint8_t* data, int length, int& frames)
+{
+    // Copy only the bytes that belong to the pending frame
+    int needed = headerLength - _pending.length();
+    if(needed <= 0) {
+        needed = frameLength(reinterpret_cast<const uint8_t*>(_pending.constData())) - _pending.length();
+    }
+    const int used = qMin(needed, length);
+    _pending.append(reinterpret_cast<const char*>(data), used);
+    if(used < needed) {
+        return used;
+    }
+
+    const uint8_t* pending = reinterpret_cast<const uint8_t*>(_pending.constData());
+    if(_pending.length() == headerLength) {
+        if(pending[1] == 'R' && validHeader(pending)) {
+            // Header is complete, wait for the rest of the frame
+            return used;
+        }
+    } else {
+        const uint16_t receivedChecksum = pending[_pending.length() - 2] | pending[_pending.length() - 1] << 8;
+        if(receivedChecksum == checksum(pending, _pending.length())) {
+            if(_handler) {
+                _handler(pending, _pending.length());
+            }
+            _parsed++;
+            frames++;
+            _pending.clear();
+            return used;
+        }
+    }
+
+    // The pending bytes are not a valid frame, look for the next sync after the first byte
+    if(pending[1] == 'R') {
+        _errors++;
+    }
+    const QByteArray invalid = _pending;
+    _pending.clear();
+    frames += scan(reinterpret_cast<const uint8_t*>(invalid.constData()) + 1, invalid.length() - 1);
+    return used;
+}
+
+int PingFrameParser::scan(const uint8_t* data, int length)
+{
+    int frames = 0;
+    const uint8_t* position = data;
+    const uint8_t* const end = data + length;
+    while(position < end) {
+        const uint8_t* start = static_cast<const uint8_t*>(memchr(position, 'B', end - position));
+        if(!start) {
+            break;
+        }
+
+        const int available = end - start;
+        if(available < 2 || start[1] != 'R') {
+            if(available < 2) {
+                _pending = QByteArray(reinterpret_cast<const char*>(start), available);
+            }
+            position = start + 1;
+            continue;
+        }
+
+        if(available < headerLength) {
+            _pending = QByteArray(reinterpret_cast<const char*>(start), available);
+            break;
+        }
+
+        if(!validHeader(start)) {
+            _errors++;
+            position = start + 1;
+            continue;
+        }
+
+        const int frameSize = frameLength(start);
+        if(available < frameSize) {
+            _pending = QByteArray(reinterpret_cast<const char*>(start), available);
+            break;
+        }
+
+        const uint16_t receivedChecksum = start[frameSize - 2] | start[frameSize - 1] << 8;
+        if(receivedChecksum != checksum(start, frameSize)) {
+            _errors++;
+            position = start + 1;
+            continue;
+        }
+
+        if(_handler) {
+            _handler(start, frameSize);
+        }
+        _parsed++;
+        frames++;
+        position = start + frameSize;
+    }
+
+    return frames;
+}
@@ -0,0 +1,141 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+
+#include <QByteArray>
+#include <QObject>
+
+/**
+ * @brief Buffer oriented parser for ping protocol frames
+ *  Received buffers are scanned as a whole: the 'BR' sync bytes are found with memchr and the checksum is
+ *  calculated over the complete frame range. Valid frames are passed to the frame handler as views into the
+ *  received buffer, only frames split between two buffers are copied.
+ *
+ *  Frame: 'B' 'R' payload_length(u16) message_id(u16) src_device_id(u8) dst_device_id(u8) payload checksum(u16)
+ *
+ */
+class PingFrameParser : public QObject
+{
+    Q_OBJECT
+public:
+    /**
+     * @brief Function called for each valid frame
+     *  The data is only valid during the call
+     */
+    typedef std::function<void(const uint8_t* data, int length)> FrameHandler;
+
+    static const int headerLength = 8;
+    static const int checksumLength = 2;
+    // Frames that claim a bigger payload are treated as corrupted
+    static const int maxPayloadLength = 8192;
+
+    /**
+     * @brief Construct a new Ping Frame Parser object
+     *
+     * @param handler
+     */
+    PingFrameParser(const FrameHandler& handler = FrameHandler());
+
+    /**
+     * @brief Set the function called for each valid frame
+     *
+     * @param handler
+     */
+    void setFrameHandler(const FrameHandler& handler) { _handler = handler; };
+
+    /**
+     * @brief Parse a received buffer
+     *
+     * @param data
+     * @param length
+     * @return int number of valid frames
+     */
+    int parse(const uint8_t* data, int length);
+
+    /**
+     * @brief Parse a received buffer
+     *
+     * @param data
+     * @return int number of valid frames
+     */
+    int parse(const QByteArray& data)
+    {
+        return parse(reinterpret_cast<const uint8_t*>(data.constData()), data.length());
+    }
+
+    /**
+     * @brief Remove the incomplete frame of the last buffer
+     *
+     */
+    void reset() { _pending.clear(); };
+
+    /**
+     * @brief Return number of valid frames, can be called from any thread
+     *
+     * @return int
+     */
+    int parsed() const { return _parsed; };
+
+    /**
+     * @brief Return number of frames with invalid length or checksum, can be called from any thread
+     *
+     * @return int
+     */
+    int errors() const { return _errors; };
+
+    /**
+     * @brief Calculate the checksum of a frame, the sum of all bytes before the checksum field
+     *
+     * @param data
+     * @param length frame length, including the checksum field
+     * @return uint16_t
+     */
+    static uint16_t checksum(const uint8_t* data, int length);
+
+    /**
+     * @brief Write the checksum field of a frame, used for outgoing messages
+     *
+     * @param data
+     * @param length frame length, including the checksum field
+     */
+    static void updateChecksum(uint8_t* data, int length);
+
+public slots:
+    /**
+     * @brief Parse a received buffer, used with AbstractLink::newData
+     *
+     * @param data
+     */
+    void parseBuffer(const QByteArray& data) { parse(data); };
+
+private:
+    Q_DISABLE_COPY(PingFrameParser)
+
+    /**
+     * @brief Scan a contiguous range for frames
+     *  An incomplete frame in the end of the range is kept in _pending
+     *
+     * @param data
+     * @param length
+     * @return int number of valid frames
+     */
+    int scan(const uint8_t* data, int length);
+
+    /**
+     * @brief Complete the pending frame with the start of a new buffer
+     *
+     * @param data
+     * @param length
+     * @param frames incremented with the number of valid frames
+     * @return int number of bytes used from data
+     */
+    int completePending(const uint8_t* data, int length, int& frames);
+
+    FrameHandler _handler;
+    // Start of a frame that was split between two buffers
+    QByteArray _pending;
+    std::atomic<int> _parsed{0};
+    std::atomic<int> _errors{0};
+};
@@ -0,0 +1,247 @@
+#pragma once
+
+#include <QString>
+#include <QtEndian>
+
+/**
+ * @brief Non owning view of a received ping message
+ *  The ping-protocol message classes copy the message to their own buffer, views read the little endian fields in
+ *  place from the buffer of the frame parser. The buffer should be valid while the view is used.
+ *  The message length should include the payload length of the header, check Ping::handleMessage.
+ *
+ */
+class PingMessageView
+{
+public:
+    /**
+     * @brief Construct a new Ping Message View object
+     *
+     * @param data message with header, payload and checksum
+     * @param length number of bytes
+     */
+    PingMessageView(const uint8_t* data, int length) : _data(data), _length(length) {};
+
+    /**
+     * @brief Return message length, with header and checksum
+     *
+     * @return int
+     */
+    int msgDataLength() const { return _length; };
+
+    uint16_t payload_length() const { return qFromLittleEndian<quint16>(_data + 2); };
+    uint16_t message_id() const { return qFromLittleEndian<quint16>(_data + 4); };
+    uint8_t src_device_id() const { return _data[6]; };
+    uint8_t dst_device_id() const { return _data[7]; };
+
+    static const int headerLength = 8;
+
+protected:
+    /**
+     * @brief Return the first byte of the payload
+     *
+     * @return const uint8_t*
+     */
+    const uint8_t* payload() const { return _data + headerLength; };
+
+    /**
+     * @brief Read a payload field
+     *
+     * @tparam T field type
+     * @param offset position in the payload
+     * @return T
+     */
+    template<typename T>
+    T field(int offset) const { return qFromLittleEndian<T>(payload() + offset); };
+
+    /**
+     * @brief Read a string field that goes until the end of the payload or a null character
+     *
+     * @param offset position in the payload
+     * @return QString
+     */
+    QString stringField(int offset) const
+    {
+        const char* string = reinterpret_cast<const char*>(payload() + offset);
+        return QString::fromUtf8(string, static_cast<int>(qstrnlen(string, payload_length() - offset)));
+    };
+
+private:
+    const uint8_t* _data;
+    int _length;
+};
+
+/**
+ * @brief Views of the ping1D messages handled by Ping
+ *  Accessors have the same names of the ping-protocol classes, isValid checks that the fields are in the payload
+ *
+ */
+namespace Ping1DView
+{
+class Ack : public PingMessageView
+{
+public:
+    using PingMessageView::PingMessageView;
+    bool isValid() const { return payload_length() >= 2; };
+    uint16_t acked_id() const { return field<quint16>(0); };
+};
+
+class Nack : public PingMessageView
+{
+public:
+    using PingMessageView::PingMessageView;
+    bool isValid() const { return payload_length() >= 2; };
+    uint16_t nacked_id() const { return field<quint16>(0); };
+    QString nack_message() const { return stringField(2); };
+};
+
+class AsciiText : public PingMessageView
+{
+public:
+    using PingMessageView::PingMessageView;
+    bool isValid() const { return true; };
+    QString ascii_message() const { return stringField(0); };
+};
+
+class FirmwareVersion : public PingMessageView
+{
+public:
+    using PingMessageView::PingMessageView;
+    bool isValid() const { return payload_length() >= 6; };
+    uint8_t device_type() const { return field<quint8>(0); };
+    uint8_t device_model() const { return field<quint8>(1); };
+    uint16_t firmware_version_major() const { return field<quint16>(2); };
+    uint16_t firmware_version_minor() const { return field<quint16>(4); };
+};
+
+class DeviceId : public PingMessageView
+{
+public:
+    using PingMessageView::PingMessageView;
+    bool isValid() const { return payload_length() >= 1; };
+    uint8_t device_id() const { return field<quint8>(0); };
+};
+
+class Distance : public PingMessageView
+{
+public:
+    using PingMessageView::PingMessageView;
+    bool isValid() const { return payload_length() >= 24; };
+    uint32_t distance() const { return field<quint32>(0); };
+    uint16_t confidence() const { return field<quint16>(4); };
+    uint16_t pulse_duration() const { return field<quint16>(6); };
+    uint32_t ping_number() const { return field<quint32>(8); };
+    uint32_t scan_start() const { return field<quint32>(12); };
+    uint32_t scan_length() const { return field<quint32>(16); };
+    uint32_t gain_index() const { return field<quint32>(20); };
+};
+
+class DistanceSimple : public PingMessageView
+{
+public:
+    using PingMessageView::PingMessageView;
+    bool isValid() const { return payload_length() >= 5; };
+    uint32_t distance() const { return field<quint32>(0); };
+    uint8_t confidence() const { return field<quint8>(4); };
+};
+
+class Profile : public Distance
+{
+public:
+    using Distance::Distance;
+    // The checksum does not validate the number of samples, they should fit in the payload after the other fields
+    bool isValid() const
+    {
+        return payload_length() >= profileDataOffset && profileDataOffset + profile_data_length() <= payload_length();
+    };
+    uint16_t profile_data_length() const { return field<quint16>(24); };
+    const uint8_t* profile_data() const { return payload() + profileDataOffset; };
+
+    static const int profileDataOffset = 26;
+};
+
+class ModeAuto : public PingMessageView
+{
+public:
+    using PingMessageView::PingMessageView;
+    bool isValid() const { return payload_length() >= 1; };
+    uint8_t mode_auto() const { return field<quint8>(0); };
+};
+
+class PingEnable : public PingMessageView
+{
+public:
+    using PingMessageView::PingMessageView;
+    bool isValid() const { return payload_length() >= 1; };
+    uint8_t ping_enabled() const { return field<quint8>(0); };
+};
+
+class PingInterval : public PingMessageView
+{
+public:
+    using PingMessageView::PingMessageView;
+    bool isValid() const { return payload_length() >= 2; };
+    uint16_t ping_interval() const { return field<quint16>(0); };
+};
+
+class Range : public PingMessageView
+{
+public:
+    using PingMessageView::PingMessageView;
+    bool isValid() const { return payload_length() >= 8; };
+    uint32_t scan_start() const { return field<quint32>(0); };
+    uint32_t scan_length() const { return field<quint32>(4); };
+};
+
+class GeneralInfo : public PingMessageView
+{
+public:
+    using PingMessageView::PingMessageView;
+    bool isValid() const { return payload_length() >= 10; };
+    uint16_t firmware_version_major() const { return field<quint16>(0); };
+    uint16_t firmware_version_minor() const { return field<quint16>(2); };
+    uint16_t voltage_5() const { return field<quint16>(4); };
+    uint16_t ping_interval() const { return field<quint16>(6); };
+    uint8_t gain_index() const { return field<quint8>(8); };
+    uint8_t mode_auto() const { return field<quint8>(9); };
+};
+
+class GainIndex : public PingMessageView
+{
+public:
+    using PingMessageView::PingMessageView;
+    bool isValid() const { return payload_length() >= 4; };
+    uint32_t gain_index() const { return field<quint32>(0); };
+};
+
+class SpeedOfSound : public PingMessageView
+{
+public:
+    using PingMessageView::PingMessageView;
+    bool isValid() const { return payload_length() >= 4; };
+    uint32_t speed_of_sound() const { return field<quint32>(0); };
+};
+
+class ProcessorTemperature : public PingMessageView
+{
+public:
+    using PingMessageView::PingMessageView;
+    bool isValid() const { return payload_length() >= 2; };
+    uint16_t processor_temperature() const { return field<quint16>(0); };
+};
+
+class PcbTemperature : public PingMessageView
+{
+public:
+    using PingMessageView::PingMessageView;
+    bool isValid() const { return payload_length() >= 2; };
+    uint16_t pcb_temperature() const { return field<quint16>(0); };
+};
+
+class Voltage5 : public PingMessageView
+{
+public:
+    using PingMessageView::PingMessageView;
+    bool isValid() const { return payload_length() >= 2; };
+    uint16_t voltage_5() const { return field<quint16>(0); };
+};
+}
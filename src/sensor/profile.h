@@ -0,0 +1,95 @@
+#pragma once
+
+#include <QByteArray>
+#include <QSharedPointer>
+
+/**
+ * @brief Immutable sonar profile
+ *  A profile is created once by the sensor and shared between all sinks without copies,
+ *  check ProfileSink and Profile::Pointer.
+ *  Samples are kept as raw 8 bits intensity, normalization is done only when colorizing or plotting.
+ *
+ */
+class Profile
+{
+public:
+    /**
+     * @brief Shared pointer used to pass profiles around
+     *
+     */
+    typedef QSharedPointer<const Profile> Pointer;
+
+    /**
+     * @brief Construct a new Profile object
+     *
+     * @param samples raw intensity (0-255) of each sample
+     * @param confidence distance confidence in percent
+     * @param initialDepth depth of the first sample in meters
+     * @param length depth range covered by the profile in meters
+     * @param distance distance of the target in meters
+     */
+    Profile(const QByteArray& samples, float confidence, float initialDepth, float length, float distance)
+        : _samples(samples)
+        , _confidence(confidence)
+        , _initialDepth(initialDepth)
+        , _length(length)
+        , _distance(distance)
+    {
+    }
+
+    /**
+     * @brief Return raw intensity (0-255) of each sample
+     *
+     * @return const QByteArray&
+     */
+    const QByteArray& samples() const { return _samples; };
+
+    /**
+     * @brief Return samples as unsigned values
+     *
+     * @return const uint8_t*
+     */
+    const uint8_t* data() const { return reinterpret_cast<const uint8_t*>(_samples.constData()); };
+
+    /**
+     * @brief Return number of samples
+     *
+     * @return int
+     */
+    int size() const { return _samples.size(); };
+
+    /**
+     * @brief Return distance confidence in percent
+     *
+     * @return float
+     */
+    float confidence() const { return _confidence; };
+
+    /**
+     * @brief Return depth of the first sample in meters
+     *
+     * @return float
+     */
+    float initialDepth() const { return _initialDepth; };
+
+    /**
+     * @brief Return depth range covered by the profile in meters
+     *
+     * @return float
+     */
+    float length() const { return _length; };
+
+    /**
+     * @brief Return distance of the target in meters
+     *
+     * @return float
+     */
+    float distance() const { return _distance; };
+
+private:
+    const QByteArray _samples;
+    const float _confidence;
+    const float _initialDepth;
+    const float _length;
+    const float _distance;
+};
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <QObject>
+
+#include "profile.h"
+
+/**
+ * @brief Interface of objects that receive profiles directly from a sensor
+ *  Sinks are QObjects registered from QML with Ping::addProfileSink, profiles are pushed from C++
+ *  without passing through the javascript engine.
+ *  A QObject sink should add ProfileSink to its base classes and Q_INTERFACES(ProfileSink).
+ *
+ */
+class ProfileSink
+{
+public:
+    virtual ~ProfileSink() = default;
+
+    /**
+     * @brief Receive a new profile
+     *  Called in the GUI thread for every profile, heavy work should be done once per frame.
+     *
+     * @param profile
+     */
+    virtual void appendProfile(const Profile::Pointer& profile) = 0;
+
+    /**
+     * @brief Remove previous profiles, the next profiles are not a continuation of them (E.g: log seek)
+     *  Sinks that only keep the last profile do not need to implement it.
+     *
+     */
+    virtual void clearProfiles() {};
+};
+
+Q_DECLARE_INTERFACE(ProfileSink, "com.bluerobotics.ping-viewer.ProfileSink")
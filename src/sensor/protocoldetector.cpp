@@ -92,7 +92,7 @@ bool ProtocolDetector::checkSerial(LinkConfiguration& linkConf)
     // To find a ping, we this message on a link, then wait for a reply
     ping_msg_ping1D_empty req;
     req.set_id(Ping1DNamespace::Firmware_version);
-    req.updateChecksum();
+    PingFrameParser::updateChecksum(req.msgData, req.msgDataLength());
 
     QSerialPortInfo portInfo(linkConf.serialPort());
     int baudrate = linkConf.serialBaudrate();
@@ -104,6 +104,7 @@ bool ProtocolDetector::checkSerial(LinkConfiguration& linkConf)
     }
 
     QSerialPort port(portInfo);
+    _parser.reset();
 
     qCDebug(PING_PROTOCOL_PROTOCOLDETECTOR) << "Probing Serial" << port.portName() << baudrate;
 
@@ -122,13 +123,7 @@ bool ProtocolDetector::checkSerial(LinkConfiguration& linkConf)
 
     while (!_detected && attempts < 10) { // Try to get a valid response, timeout after 10 * 50 ms
         port.waitForReadyRead(50);
-        auto buf = port.readAll();
-        for (const auto& byte : buf) {
-            _detected = _parser.parseByte(byte) == PingParser::NEW_MESSAGE;
-            if (_detected) {
-                break;
-            }
-        }
+        _detected = _parser.parse(port.readAll()) > 0;
         attempts++;
     }
 
@@ -142,9 +137,10 @@ bool ProtocolDetector::checkUdp(LinkConfiguration& linkConf)
     // To find a ping, we this message on a link, then wait for a reply
     ping_msg_ping1D_empty req;
     req.set_id(Ping1DNamespace::Firmware_version);
-    req.updateChecksum();
+    PingFrameParser::updateChecksum(req.msgData, req.msgDataLength());
 
     QUdpSocket socket;
+    _parser.reset();
 
     // To test locally, change the host to 127.0.0.1 and use something like:
     // nc -kul 127.0.0.1 8888 > /dev/ttyUSB0 < /dev/ttyUSB0
@@ -163,13 +159,7 @@ bool ProtocolDetector::checkUdp(LinkConfiguration& linkConf)
     while (!_detected && attempts++ < 10) {
         socket.waitForReadyRead(50);
         QNetworkDatagram datagram = socket.receiveDatagram();
-        auto buf = datagram.data();
-        for (auto byte : buf) {
-            _detected = _parser.parseByte(byte) == PingParser::NEW_MESSAGE;
-            if (_detected) {
-                break;
-            }
-        }
+        _detected = _parser.parse(datagram.data()) > 0;
         attempts++;
     }
 
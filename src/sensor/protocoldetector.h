@@ -4,7 +4,7 @@
 
 #include "abstractlink.h"
 #include "linkconfiguration.h"
-#include "parsers/parser_ping.h"
+#include "pingframeparser.h"
 
 class QSerialPortInfo;
 
@@ -106,6 +106,6 @@ private:
     bool _detected { false };
     QVector<LinkConfiguration> _availableLinks;
     QVector<LinkConfiguration> _linkConfigs;
-    PingParser _parser;
+    PingFrameParser _parser;
     static const QStringList _invalidSerialPortNames;
 };
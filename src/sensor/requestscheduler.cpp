@@ -0,0 +1,230 @@
+#include "requestscheduler.h"
+
+// Interval between housekeeping requests when the link is idle
+static const int housekeepingBaseInterval = 1000;
+static const int housekeepingMaxInterval = 10000;
+// Housekeeping requests wait while the link usage is above this
+static const float housekeepingMaxUsage = 0.8f;
+// Window used to measure the received data rate
+static const int receivedWindow = 1000;
+// Reply size used before any reply is received, close to a profile with 1200 samples
+static const int defaultReplyBytes = 1250;
+
+RequestScheduler::RequestScheduler(const Sender& sender, QObject* parent)
+    : QObject(parent)
+    , _sender(sender)
+    , _timer(this)
+    , _maxInFlight(2)
+    , _timeout(500)
+    , _maxRetries(2)
+    , _lostRequests(0)
+    , _linkCapacity(0)
+    , _maxReplyBytes(0)
+    , _receivedRate(0)
+    , _receivedBytes(0)
+    , _receivedWindowStart(0)
+{
+    _clock.start();
+    _timer.setInterval(20);
+    connect(&_timer, &QTimer::timeout, this, [this] {
+        checkTimeouts();
+        schedule();
+        if(_inFlight.isEmpty() && !pending()) {
+            _timer.stop();
+        }
+    });
+}
+
+void RequestScheduler::request(int id, Priority priority)
+{
+    if(contains(id)) {
+        return;
+    }
+
+    _queues[priority].enqueue({id, priority, 0, 0, 0});
+    schedule();
+    if(!_timer.isActive()) {
+        _timer.start();
+    }
+}
+
+void RequestScheduler::replied(int id, qint64 timestamp, int bytes)
+{
+    if(timestamp < 0) {
+        timestamp = this->timestamp();
+    }
+
+    if(bytes > 0) {
+        _replyBytes[id] = bytes;
+        _maxReplyBytes = qMax(_maxReplyBytes, bytes);
+    }
+
+    for(int i = 0; i < _inFlight.size(); i++) {
+        const Request& request = _inFlight[i];
+        if(request.id != id) {
+            continue;
+        }
+
+        Statistics& statistics = _statistics[id];
+        statistics.replies++;
+        statistics.lastLatency = qMax<qint64>(0, timestamp - request.sentTime)/1000;
+        statistics.latency.record(statistics.lastLatency);
+
+        _inFlight.remove(i);
+        schedule();
+        return;
+    }
+}
+
+void RequestScheduler::clear()
+{
+    for(auto& queue : _queues) {
+        queue.clear();
+    }
+    _inFlight.clear();
+    _timer.stop();
+}
+
+void RequestScheduler::addReceivedBytes(int bytes)
+{
+    _receivedBytes += bytes;
+    const qint64 now = _clock.elapsed();
+    const qint64 elapsed = now - _receivedWindowStart;
+    if(elapsed < receivedWindow) {
+        return;
+    }
+
+    // Smooth the rate between windows
+    const float rate = _receivedBytes*1000.0f/elapsed;
+    _receivedRate = _receivedRate > 0 ? (_receivedRate + rate)/2 : rate;
+    _receivedBytes = 0;
+    _receivedWindowStart = now;
+}
+
+float RequestScheduler::linkUsage() const
+{
+    if(_linkCapacity <= 0) {
+        return 0;
+    }
+    return qMin(1.0f, _receivedRate/_linkCapacity);
+}
+
+int RequestScheduler::housekeepingInterval() const
+{
+    // The interval increases as the free capacity goes to zero
+    const float freeCapacity = 1.0f - linkUsage();
+    if(freeCapacity <= housekeepingBaseInterval/float(housekeepingMaxInterval)) {
+        return housekeepingMaxInterval;
+    }
+    return qMin(housekeepingMaxInterval, qRound(housekeepingBaseInterval/freeCapacity));
+}
+
+int RequestScheduler::replyTimeout(int id) const
+{
+    if(_linkCapacity <= 0) {
+        return _timeout;
+    }
+
+    int bytes = replyBytes(id);
+    for(const auto& request : _inFlight) {
+        bytes += replyBytes(request.id);
+    }
+    return _timeout + static_cast<int>(bytes*1000LL/_linkCapacity);
+}
+
+int RequestScheduler::replyBytes(int id) const
+{
+    return _replyBytes.value(id, _maxReplyBytes > 0 ? _maxReplyBytes : defaultReplyBytes);
+}
+
+int RequestScheduler::pending() const
+{
+    int size = 0;
+    for(const auto& queue : _queues) {
+        size += queue.size();
+    }
+    return size;
+}
+
+bool RequestScheduler::contains(int id) const
+{
+    for(const auto& request : _inFlight) {
+        if(request.id == id) {
+            return true;
+        }
+    }
+    for(const auto& queue : _queues) {
+        for(const auto& request : queue) {
+            if(request.id == id) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+void RequestScheduler::schedule()
+{
+    while(_inFlight.size() < _maxInFlight) {
+        QQueue<Request>* queue = nullptr;
+        for(int priority = 0; priority < PriorityCount; priority++) {
+            if(!_queues[priority].isEmpty()) {
+                queue = &_queues[priority];
+                break;
+            }
+        }
+
+        if(!queue) {
+            return;
+        }
+
+        // Housekeeping can wait for the link to be less busy
+        if(queue->head().priority == Housekeeping && linkUsage() > housekeepingMaxUsage) {
+            return;
+        }
+
+        Request request = queue->dequeue();
+        request.sentTime = timestamp();
+        request.timeout = replyTimeout(request.id);
+        _inFlight.append(request);
+        _statistics[request.id].requests++;
+        if(_sender) {
+            _sender(request.id);
+        }
+    }
+}
+
+void RequestScheduler::checkTimeouts()
+{
+    const qint64 now = timestamp();
+    for(int i = _inFlight.size() - 1; i >= 0; i--) {
+        Request request = _inFlight[i];
+        if(now - request.sentTime < request.timeout*1000000LL) {
+            continue;
+        }
+
+        _inFlight.remove(i);
+        Statistics& statistics = _statistics[request.id];
+        statistics.timeouts++;
+        if(request.retries < _maxRetries) {
+            // Retries go to the front of their queue
+            request.retries++;
+            statistics.retries++;
+            _queues[request.priority].prepend(request);
+        } else {
+            _lostRequests++;
+        }
+    }
+}
+
+QDebug operator<<(QDebug d, const RequestScheduler::Statistics& statistics)
+{
+    QDebugStateSaver saver(d);
+    d.nospace() << "requests: " << statistics.requests << ", replies: " << statistics.replies
+                << ", retries: " << statistics.retries << ", timeouts: " << statistics.timeouts
+                << ", latency (last/p50/p99/max ms): " << statistics.lastLatency/1000.0
+                << "/" << statistics.latency.valueAtPercentile(50)/1000.0
+                << "/" << statistics.latency.valueAtPercentile(99)/1000.0
+                << "/" << statistics.latency.max()/1000.0;
+    return d;
+}
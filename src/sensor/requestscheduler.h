@@ -0,0 +1,267 @@
+#pragma once
+
+#include <array>
+#include <functional>
+
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QObject>
+#include <QQueue>
+#include <QTimer>
+#include <QVector>
+
+#include "latencyhistogram.h"
+
+/**
+ * @brief Schedule message requests to a sensor
+ *  Requests are queued by priority and only a limited number of requests wait for a reply at the same time,
+ *  this avoids bursts on slow links. Requests without reply are sent again after a timeout, and the same id is
+ *  never queued twice. The timeout includes the time to receive the replies with the link capacity.
+ *  Received data is measured to reduce the housekeeping rate when the link is busy.
+ *
+ */
+class RequestScheduler : public QObject
+{
+    Q_OBJECT
+public:
+    /**
+     * @brief Request priorities, requests with higher priority are always sent first
+     *
+     */
+    enum Priority {
+        Streaming,      // Data that the user is waiting for, E.g: profiles
+        Configuration,  // Device information and configuration replies
+        Housekeeping,   // Periodic status, E.g: temperatures and voltages
+        PriorityCount,
+    };
+
+    /**
+     * @brief Request statistics of a message id
+     *  Latency is the time between the request being written and the reply being received, in microseconds
+     */
+    struct Statistics {
+        int requests = 0;
+        int replies = 0;
+        int retries = 0;
+        int timeouts = 0;
+        qint64 lastLatency = 0;
+        LatencyHistogram latency;
+    };
+
+    /**
+     * @brief Function that writes a request to the link
+     *
+     */
+    typedef std::function<void(int id)> Sender;
+
+    /**
+     * @brief Construct a new Request Scheduler object
+     *
+     * @param sender
+     * @param parent
+     */
+    RequestScheduler(const Sender& sender = Sender(), QObject* parent = nullptr);
+
+    /**
+     * @brief Set the function that writes requests
+     *
+     * @param sender
+     */
+    void setSender(const Sender& sender) { _sender = sender; };
+
+    /**
+     * @brief Queue a request, nothing is done if the id is already queued or waiting for a reply
+     *
+     * @param id
+     * @param priority
+     */
+    void request(int id, Priority priority = Configuration);
+
+    /**
+     * @brief Handle the reply of a request, a NACK is also a reply
+     *
+     * @param id
+     * @param timestamp time when the reply was received, check timestamp(), -1 to use the current time
+     * @param bytes size of the reply, it's used to estimate the time of the next replies, 0 if unknown
+     */
+    void replied(int id, qint64 timestamp = -1, int bytes = 0);
+
+    /**
+     * @brief Return the scheduler clock, it can be called from any thread
+     *
+     * @return qint64 nanoseconds
+     */
+    qint64 timestamp() const { return _clock.nsecsElapsed(); };
+
+    /**
+     * @brief Remove all queued and waiting requests, statistics are kept
+     *
+     */
+    void clear();
+
+    /**
+     * @brief Add received bytes to the link usage measurement
+     *
+     * @param bytes
+     */
+    void addReceivedBytes(int bytes);
+
+    /**
+     * @brief Set the link capacity
+     *
+     * @param bytesPerSecond 0 if unknown
+     */
+    void setLinkCapacity(int bytesPerSecond) { _linkCapacity = bytesPerSecond; };
+
+    /**
+     * @brief Return the measured received data rate
+     *
+     * @return float bytes per second
+     */
+    float receivedRate() const { return _receivedRate; };
+
+    /**
+     * @brief Return the used fraction of the link capacity
+     *
+     * @return float between 0 and 1, 0 if the capacity is unknown
+     */
+    float linkUsage() const;
+
+    /**
+     * @brief Return the interval between housekeeping requests, it increases with the link usage
+     *
+     * @return int milliseconds
+     */
+    int housekeepingInterval() const;
+
+    /**
+     * @brief Set the maximum number of requests waiting for a reply
+     *
+     * @param maxInFlight
+     */
+    void setMaxInFlight(int maxInFlight) { _maxInFlight = qMax(1, maxInFlight); schedule(); };
+
+    /**
+     * @brief Set the reply timeout, the time to receive the replies is added to it
+     *
+     * @param milliseconds
+     */
+    void setTimeout(int milliseconds) { _timeout = milliseconds; };
+
+    /**
+     * @brief Return the timeout of a request sent now
+     *  The replies of the requests waiting for a reply arrive first, so their size is also used
+     *
+     * @param id
+     * @return int milliseconds
+     */
+    int replyTimeout(int id) const;
+
+    /**
+     * @brief Set the number of times that a request is sent again after a timeout
+     *
+     * @param retries
+     */
+    void setMaxRetries(int retries) { _maxRetries = retries; };
+
+    /**
+     * @brief Return the number of requests waiting for a reply
+     *
+     * @return int
+     */
+    int inFlight() const { return _inFlight.size(); };
+
+    /**
+     * @brief Return the number of queued requests
+     *
+     * @return int
+     */
+    int pending() const;
+
+    /**
+     * @brief Return the number of requests that timed out after all retries
+     *
+     * @return int
+     */
+    int lostRequests() const { return _lostRequests; };
+
+    /**
+     * @brief Return statistics of a message id
+     *
+     * @param id
+     * @return Statistics
+     */
+    Statistics statistics(int id) const { return _statistics.value(id); };
+
+    /**
+     * @brief Return all ids with statistics
+     *
+     * @return QList<int>
+     */
+    QList<int> requestedIds() const { return _statistics.keys(); };
+
+private:
+    Q_DISABLE_COPY(RequestScheduler)
+
+    struct Request {
+        int id;
+        Priority priority;
+        int retries;
+        // Nanoseconds from the scheduler clock
+        qint64 sentTime;
+        // Milliseconds, check replyTimeout
+        int timeout;
+    };
+
+    /**
+     * @brief Check if a request is queued or waiting for a reply
+     *
+     * @param id
+     * @return true
+     * @return false
+     */
+    bool contains(int id) const;
+
+    /**
+     * @brief Return the expected size of a reply
+     *
+     * @param id
+     * @return int bytes
+     */
+    int replyBytes(int id) const;
+
+    /**
+     * @brief Send queued requests while the in-flight limit and the link usage allow it
+     *
+     */
+    void schedule();
+
+    /**
+     * @brief Send again or drop requests without reply
+     *
+     */
+    void checkTimeouts();
+
+    Sender _sender;
+    std::array<QQueue<Request>, PriorityCount> _queues;
+    QVector<Request> _inFlight;
+    QHash<int, Statistics> _statistics;
+    QElapsedTimer _clock;
+    QTimer _timer;
+
+    int _maxInFlight;
+    int _timeout;
+    int _maxRetries;
+    int _lostRequests;
+
+    int _linkCapacity;
+    // Size of the last reply of each id and of the biggest reply
+    QHash<int, int> _replyBytes;
+    int _maxReplyBytes;
+    float _receivedRate;
+    int _receivedBytes;
+    qint64 _receivedWindowStart;
+};
+
+QDebug operator<<(QDebug d, const RequestScheduler::Statistics& statistics);
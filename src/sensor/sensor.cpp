@@ -14,10 +14,16 @@ Sensor::Sensor() :
     _autodetect(true)
     ,_connected(false)
     ,_detector(new ProtocolDetector())
-    ,_linkIn(new Link(LinkType::Serial, "Default"))
+    ,_linkThreadContext(new QObject())
+    ,_linkIn(new Link(LinkType::Serial, "Default"), &QObject::deleteLater)
     ,_linkOut(nullptr)
-    ,_parser(nullptr)
 {
+    _linkThread.setObjectName(QStringLiteral("Link"));
+    _linkThreadContext->moveToThread(&_linkThread);
+    connect(&_linkThread, &QThread::finished, _linkThreadContext, &QObject::deleteLater);
+    _linkIn->moveToThread(&_linkThread);
+    _linkThread.start();
+
     emit connectionUpdate();
     connect(this, &Sensor::connectionOpen, this, [this] {
         this->_connected = true;
@@ -44,7 +50,7 @@ void Sensor::connectLink(const LinkConfiguration& conConf, const LinkConfigurati
     }
 
     if(link()->isOpen()) {
-        link()->finishConnection();
+        runInLinkThread([this] { link()->finishConnection(); });
     }
 
     qCDebug(PING_PROTOCOL_SENSOR) << "Connecting to" << conConf;
@@ -55,8 +61,8 @@ void Sensor::connectLink(const LinkConfiguration& conConf, const LinkConfigurati
     if(link()) {
         _linkIn.clear();
     }
-    _linkIn = QSharedPointer<Link>(new Link(conConf));
-    link()->startConnection();
+    _linkIn = createLink(conConf);
+    runInLinkThread([this] { link()->startConnection(); });
 
     if(!link()->isOpen()) {
         qCCritical(PING_PROTOCOL_SENSOR) << "Connection fail !" << conConf << link()->errorString();;
@@ -66,10 +72,6 @@ void Sensor::connectLink(const LinkConfiguration& conConf, const LinkConfigurati
 
     emit linkUpdate();
 
-    if (_parser) {
-        connect(link(), &AbstractLink::newData, _parser, &Parser::parseBuffer);
-    }
-
     emit connectionOpen();
 
     // Disable log if playing one
@@ -80,7 +82,7 @@ void Sensor::connectLink(const LinkConfiguration& conConf, const LinkConfigurati
         }
 
         if(linkLog()->isOpen()) {
-            linkLog()->finishConnection();
+            runInLinkThread([this] { linkLog()->finishConnection(); });
             _linkOut.clear();
         }
     } else {
@@ -107,8 +109,8 @@ void Sensor::connectLinkLog(const LinkConfiguration& logConf)
         return;
     }
 
-    _linkOut = QSharedPointer<Link>(new Link(logConf));
-    linkLog()->startConnection();
+    _linkOut = createLink(logConf);
+    runInLinkThread([this] { linkLog()->startConnection(); });
 
     if(!linkLog()->isOpen()) {
         qCCritical(PING_PROTOCOL_SENSOR) << "Connection with log fail !" << logConf << linkLog()->errorString();
@@ -119,6 +121,14 @@ void Sensor::connectLinkLog(const LinkConfiguration& logConf)
     emit linkLogUpdate();
 }
 
+QSharedPointer<Link> Sensor::createLink(const LinkConfiguration& linkConfiguration)
+{
+    // Links are deleted in their own thread
+    QSharedPointer<Link> link(new Link(linkConfiguration), &QObject::deleteLater);
+    link->moveToThread(&_linkThread);
+    return link;
+}
+
 void Sensor::setAutoDetect(bool autodetect)
 {
     if(_autodetect == autodetect) {
@@ -133,4 +143,10 @@ Sensor::~Sensor()
     _detector->stop();
     _detectorThread.quit();
     _detectorThread.wait();
+
+    // Pending deleteLater calls are processed when the thread finishes
+    _linkIn.clear();
+    _linkOut.clear();
+    _linkThread.quit();
+    _linkThread.wait();
 }
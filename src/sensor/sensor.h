@@ -1,9 +1,9 @@
 #pragma once
 
 #include <QPointer>
+#include <QThread>
 
 #include "link.h"
-#include "parsers/parser.h"
 #include "protocoldetector.h"
 
 // TODO: rename to Device?
@@ -94,14 +94,47 @@ public:
      */
     QThread* detectorThread() { return &_detectorThread; };
 
+    /**
+     * @brief Return the I/O thread, links and parser live in this thread
+     *
+     * @return QThread*
+     */
+    QThread* linkThread() { return &_linkThread; };
+
 protected:
+    /**
+     * @brief Run a function in the I/O thread and wait for it to finish
+     *  Link functions that touch the device (open, close, flush) should be called with it
+     *
+     * @param function
+     */
+    template <typename Function>
+    void runInLinkThread(Function function)
+    {
+        if(QThread::currentThread() == &_linkThread) {
+            function();
+            return;
+        }
+        QMetaObject::invokeMethod(_linkThreadContext, function, Qt::BlockingQueuedConnection);
+    }
+
+    /**
+     * @brief Create a link that lives in the I/O thread
+     *
+     * @param linkConfiguration
+     * @return QSharedPointer<Link>
+     */
+    QSharedPointer<Link> createLink(const LinkConfiguration& linkConfiguration);
+
     bool _autodetect;
     bool _connected;
     ProtocolDetector* _detector;
     QThread _detectorThread;
+    // Links and parser live in this thread, so UI stalls do not delay reads
+    QThread _linkThread;
+    QObject* _linkThreadContext;
     QSharedPointer<Link> _linkIn;
     QSharedPointer<Link> _linkOut;
-    Parser* _parser; // communication implementation
 
     QString _name; // TODO: populate
 
@@ -3,10 +3,15 @@
 #include "parsers/parser_json.h"
 
 SensorArbitrary::SensorArbitrary()
+    : _parser(new JsonParser())
 {
-    _parser = new JsonParser();
+    _parser->moveToThread(linkThread());
+    connect(linkThread(), &QThread::finished, _parser, &QObject::deleteLater);
     connect(dynamic_cast<JsonParser*>(_parser), &JsonParser::newJsonObject, this, &SensorArbitrary::handleJsonObject);
     connect(link(), &AbstractLink::newData, _parser, &Parser::parseBuffer);
+    connect(this, &Sensor::linkUpdate, this, [this] {
+        connect(link(), &AbstractLink::newData, _parser, &Parser::parseBuffer);
+    });
 }
 
 void SensorArbitrary::handleJsonObject(const QJsonObject& obj)
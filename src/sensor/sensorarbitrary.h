@@ -3,6 +3,7 @@
 #include <QJsonObject>
 #include <QVariant>
 
+#include "parsers/parser.h"
 #include "sensor.h"
 
 /**
@@ -40,6 +41,7 @@ private:
     // TODO: maybe QMap<QString, QVariant>
     QString _name;
     QVariant _value;
+    Parser* _parser; // communication implementation
 
     void handleJsonObject(const QJsonObject& obj);
 };
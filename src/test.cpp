@@ -1,22 +1,45 @@
 #define private public
 #define protected public
 
+#include <limits>
+#include <numeric>
+#include <thread>
+
 #include <QApplication>
 #include <QQmlApplicationEngine>
 #include <QQmlContext>
 #include <QQmlEngine>
 #include <QQuickStyle>
+#include <QQuickWindow>
 #include <QDebug>
 #include <QRegularExpression>
+#include <QSignalSpy>
+#include <QTemporaryDir>
+#include <QTemporaryFile>
 
 #include "abstractlink.h"
+#include "bufferpool.h"
+#include "checksum.h"
+#include "columnkernel.h"
+#include "columnsmoother.h"
 #include "filemanager.h"
+#include "latencyhistogram.h"
 #include "linkconfiguration.h"
 #include "logger.h"
+#include "logindexer.h"
+#include "logreader.h"
+#include "logthread.h"
+#include "logwriter.h"
 #include "ping.h"
+#include "pingframeparser.h"
+#include "profilesink.h"
+#include "requestscheduler.h"
+#include "ringvector.h"
 #include "settingsmanager.h"
+#include "spscqueue.h"
 #include "util.h"
 #include "waterfall.h"
+#include "waterfallpyramid.h"
 
 #include "test.h"
 
@@ -94,6 +117,51 @@ void Test::ringVector()
         QVERIFY2(ring[i] == size - 1 - i,
                  qPrintable(QString("Ring is not working: Ring[%2]=%1").arg(ring[i]).arg(i)));
     }
+
+    // Iterators go from the oldest to the newest value
+    int expected = 0;
+    for(const auto item : ring) {
+        QVERIFY2(item == expected, qPrintable(QString("Ring order is wrong: %1 != %2").arg(item).arg(expected)));
+        expected++;
+    }
+
+    // Bulk append keeps the last length values and the spans cover the ring in order
+    QVector<int> bulkValues(size*3/2);
+    std::iota(bulkValues.begin(), bulkValues.end(), size);
+    ring.appendBulk(bulkValues.constData(), 30);
+    ring.appendBulk(bulkValues.constData() + 30, bulkValues.length() - 30);
+    const RingVector<int>& constRing = ring;
+    for(int i{0}; i < constRing.length(); i++) {
+        QVERIFY2(constRing[i] == bulkValues.last() - i,
+                 qPrintable(QString("Bulk append is not working: Ring[%2]=%1").arg(constRing[i]).arg(i)));
+    }
+    const auto firstSpan = ring.firstSpan();
+    const auto secondSpan = ring.secondSpan();
+    QVERIFY2(firstSpan.length + secondSpan.length == size,
+             qPrintable(QString("Spans have the wrong size: %1").arg(firstSpan.length + secondSpan.length)));
+    QVector<int> spans;
+    std::copy(firstSpan.data, firstSpan.data + firstSpan.length, std::back_inserter(spans));
+    std::copy(secondSpan.data, secondSpan.data + secondSpan.length, std::back_inserter(spans));
+    QVERIFY2(spans == bulkValues.mid(bulkValues.length() - size), qPrintable("Spans are not in order."));
+
+    // Check sliding window min and max against a full scan
+    const int window = 10;
+    RingWindowExtreme<int> minWindow(window);
+    RingWindowExtreme<int, std::greater<int>> maxWindow(window);
+    QVector<int> values;
+    for(int i{0}; i < 200; i++) {
+        const int value = (i*37)%101 - (i%13 == 0 ? 500 : 0);
+        values.append(value);
+        minWindow.append(value);
+        maxWindow.append(value);
+
+        const auto last = values.mid(qMax(0, values.length() - window));
+        const int min = *std::min_element(last.begin(), last.end());
+        const int max = *std::max_element(last.begin(), last.end());
+        QVERIFY2(minWindow.value() == min && maxWindow.value() == max,
+                 qPrintable(QString("Window is not working [%1]: %2 != %3 or %4 != %5")
+                            .arg(i).arg(minWindow.value()).arg(min).arg(maxWindow.value()).arg(max)));
+    }
 }
 
 void Test::settingsManager()
@@ -132,6 +200,45 @@ void Test::settingsManager()
              qPrintable(QString("Distance scalar in meters is wrong: %1").arg(scalar)));
 }
 
+void Test::spscQueue()
+{
+    SpscQueue<int> queue(100);
+    QVERIFY2(queue.capacity() == 128, qPrintable(QString("Wrong capacity: %1").arg(queue.capacity())));
+
+    // Full and empty queue
+    int value = -1;
+    QVERIFY2(!queue.pop(value), qPrintable("Empty queue returned a value."));
+    for(int i{0}; i < queue.capacity(); i++) {
+        QVERIFY2(queue.push(i), qPrintable(QString("Push failed: %1").arg(i)));
+    }
+    QVERIFY2(!queue.push(-1), qPrintable("Full queue accepted a value."));
+    for(int i{0}; i < queue.capacity(); i++) {
+        QVERIFY2(queue.pop(value) && value == i, qPrintable(QString("Wrong value: %1 != %2").arg(value).arg(i)));
+    }
+
+    // Values should arrive in order while both threads are running
+    const int numberOfValues = 1000000;
+    std::thread producer([&queue] {
+        for(int i{0}; i < numberOfValues;) {
+            if(queue.push(i)) {
+                i++;
+            }
+        }
+    });
+
+    int expected = 0;
+    bool ordered = true;
+    while(expected < numberOfValues) {
+        if(queue.pop(value)) {
+            ordered = ordered && value == expected;
+            expected++;
+        }
+    }
+    producer.join();
+    QVERIFY2(ordered, qPrintable("Values arrived out of order."));
+    QVERIFY2(queue.size() == 0, qPrintable(QString("Queue is not empty: %1").arg(queue.size())));
+}
+
 void Test::waterfallGradient()
 {
     QVector<QColor> colorList = {Qt::black, Qt::white};
@@ -169,6 +276,897 @@ void Test::waterfallGradient()
     QVERIFY2(qFuzzyCompare(value1, 1),
              qPrintable(QString("Value does not match: %1").arg(value1)));
 
+    // Check if the color table matches the gradient interpolation
+    QVERIFY2(gradient.colorTable().size() == 256,
+             qPrintable(QString("Color table size is wrong: %1").arg(gradient.colorTable().size())));
+    for(int i{0}; i < gradient.colorTable().size(); i++) {
+        const QColor tableColor = QColor::fromRgb(gradient.getRgb(i));
+        const QColor color = gradient.getColor(i/255.0f);
+        QVERIFY2(tableColor == color,
+                 qPrintable(QString("Color table does not match [%1]: %2 != %3")
+                            .arg(i).arg(tableColor.name(), color.name())));
+    }
+}
+
+void Test::columnKernel()
+{
+    QVector<uint8_t> samples(1000);
+    for(int i{0}; i < samples.size(); i++) {
+        samples[i] = static_cast<uint8_t>((i*37 + i/7)%256);
+    }
+
+    // Values with exact float representation, avoiding rounding differences between SIMD and scalar versions
+    const QVector<float> steps = {0.25f, 0.5f, 1.0f, 1.5f, 3.0f, 17.0f};
+    const QVector<float> firstSamples = {-2.0f, 0.125f, 10.25f};
+    const QVector<ColumnKernel::Mode> modes = {ColumnKernel::Nearest, ColumnKernel::Linear, ColumnKernel::Max};
+    for(const int length : {1, 7, 200, 1000}) {
+        for(const float step : steps) {
+            for(const float firstSample : firstSamples) {
+                for(const int rows : {1, 5, 33, 800}) {
+                    for(const auto mode : modes) {
+                        QVector<uint8_t> simd(rows);
+                        QVector<uint8_t> scalar(rows);
+                        ColumnKernel::resample(samples.constData(), length, firstSample, step, simd.data(), rows, mode);
+                        ColumnKernel::resampleScalar(samples.constData(), length, firstSample, step, scalar.data(),
+                                                     rows, mode);
+                        QVERIFY2(simd == scalar,
+                                 qPrintable(QString("Kernel mismatch: length %1, step %2, first %3, rows %4, mode %5")
+                                            .arg(length).arg(step).arg(firstSample).arg(rows).arg(mode)));
+                    }
+                }
+            }
+        }
+    }
+
+    // One sample per row should return the same column
+    QVector<uint8_t> rows(samples.size());
+    for(const auto mode : modes) {
+        ColumnKernel::resample(samples.constData(), samples.size(), 0.5f, 1.0f, rows.data(), rows.size(), mode);
+        QVERIFY2(rows == samples, qPrintable(QString("Identity resample failed with mode %1").arg(mode)));
+    }
+
+    // Max should keep a thin target when downsampling
+    QVector<uint8_t> target(200, 0);
+    target[101] = 255;
+    rows.resize(20);
+    ColumnKernel::resample(target.constData(), target.size(), 5.0f, 10.0f, rows.data(), rows.size(),
+                           ColumnKernel::Max);
+    QVERIFY2(rows.contains(255), qPrintable("Max resample lost a thin target."));
+
+    // Colorize should follow the color table and stride
+    QVector<uint32_t> colorTable(256);
+    for(int i{0}; i < colorTable.size(); i++) {
+        colorTable[i] = 0xff000000 | i;
+    }
+    QVector<uint32_t> pixels(samples.size()*2, 0);
+    ColumnKernel::colorize(samples.constData(), samples.size(), colorTable.constData(), pixels.data(), 2);
+    for(int i{0}; i < samples.size(); i++) {
+        QVERIFY2(pixels[i*2] == colorTable[samples[i]] && pixels[i*2 + 1] == 0,
+                 qPrintable(QString("Colorize failed in pixel %1").arg(i)));
+    }
+}
+
+void Test::columnKernelBenchmark_data()
+{
+    QTest::addColumn<int>("kernel");
+    QTest::addColumn<int>("rows");
+
+    // Kernel -1 is the previous per row loop
+    for(const int rows : {100, 2500}) {
+        QTest::newRow(qPrintable(QString("loop %1 rows").arg(rows))) << -1 << rows;
+        QTest::newRow(qPrintable(QString("nearest %1 rows").arg(rows))) << int(ColumnKernel::Nearest) << rows;
+        QTest::newRow(qPrintable(QString("linear %1 rows").arg(rows))) << int(ColumnKernel::Linear) << rows;
+        QTest::newRow(qPrintable(QString("max %1 rows").arg(rows))) << int(ColumnKernel::Max) << rows;
+    }
+}
+
+void Test::columnKernelBenchmark()
+{
+    QFETCH(int, kernel);
+    QFETCH(int, rows);
+
+    const int columnLength = 200;
+    const int columns = 500;
+    QVector<uint8_t> samples(columnLength);
+    for(int i{0}; i < columnLength; i++) {
+        samples[i] = static_cast<uint8_t>(i*7);
+    }
+    auto gradient = WaterfallGradient(QStringLiteral("Benchmark"), {Qt::black, Qt::white});
+    QImage image(columns, rows, QImage::Format_ARGB32_Premultiplied);
+    const int stride = image.bytesPerLine()/sizeof(QRgb);
+    const float samplesPerRow = columnLength/float(rows);
+    const float firstSample = 0.5f*samplesPerRow;
+    QVector<uint8_t> rowBuffer(rows);
+
+    QBENCHMARK {
+        for(int imageColumn{0}; imageColumn < columns; imageColumn++) {
+            QRgb* column = reinterpret_cast<QRgb*>(image.bits()) + imageColumn;
+            if(kernel < 0) {
+                for(int row{0}; row < rows; row++) {
+                    const int sample = qBound(0, static_cast<int>(firstSample + row*samplesPerRow), columnLength - 1);
+                    column[row*stride] = gradient.getRgb(samples[sample]);
+                }
+            } else {
+                ColumnKernel::resample(samples.constData(), columnLength, firstSample, samplesPerRow, rowBuffer.data(),
+                                       rows, static_cast<ColumnKernel::Mode>(kernel));
+                ColumnKernel::colorize(rowBuffer.constData(), rows, gradient.colorTable().constData(), column, stride);
+            }
+        }
+    }
+}
+
+void Test::columnSmoother()
+{
+    // SIMD kernels against the scalar ones
+    for(const int length : {1, 7, 8, 9, 200, 1001}) {
+        QVector<uint8_t> samples(length);
+        QVector<float> floatState(length, 0);
+        QVector<float> floatStateScalar(length, 0);
+        QVector<int16_t> fixedState(length, 0);
+        QVector<int16_t> fixedStateScalar(length, 0);
+        QVector<uint8_t> output(length);
+        QVector<uint8_t> outputScalar(length);
+        for(int iteration{0}; iteration < 20; iteration++) {
+            for(int i{0}; i < length; i++) {
+                samples[i] = static_cast<uint8_t>((i*37 + iteration*101)%256);
+            }
+
+            ColumnKernel::smooth(samples.constData(), length, int16_t(6554), fixedState.data(), output.data());
+            ColumnKernel::smoothScalar(samples.constData(), length, int16_t(6554), fixedStateScalar.data(),
+                                       outputScalar.data());
+            QVERIFY2(fixedState == fixedStateScalar && output == outputScalar,
+                     qPrintable(QString("Fixed-point smooth mismatch with length %1").arg(length)));
+
+            ColumnKernel::smooth(samples.constData(), length, 0.2f, floatState.data(), output.data());
+            ColumnKernel::smoothScalar(samples.constData(), length, 0.2f, floatStateScalar.data(),
+                                       outputScalar.data());
+            for(int i{0}; i < length; i++) {
+                QVERIFY2(qAbs(output[i] - outputScalar[i]) <= 1,
+                         qPrintable(QString("Float smooth mismatch with length %1 in %2").arg(length).arg(i)));
+            }
+        }
+    }
+
+    for(const auto storage : {ColumnSmoother::Float, ColumnSmoother::FixedPoint}) {
+        ColumnSmoother smoother(0.5f, storage);
+        QVector<uint8_t> output(300);
+
+        // First column is the initial state
+        QVector<uint8_t> samples(200, 100);
+        smoother.apply(samples.constData(), samples.size(), output.data());
+        QVERIFY2(output[0] == 100, qPrintable(QString("Wrong initial state: %1").arg(output[0])));
+
+        samples.fill(200);
+        smoother.apply(samples.constData(), samples.size(), output.data());
+        QVERIFY2(output[0] == 150 && output[199] == 150,
+                 qPrintable(QString("Wrong smooth value: %1").arg(output[0])));
+
+        // A different profile length restarts the filter
+        QVector<uint8_t> longSamples(300, 20);
+        smoother.apply(longSamples.constData(), longSamples.size(), output.data());
+        QVERIFY2(output[0] == 20 && output[299] == 20,
+                 qPrintable(QString("Filter was not restarted: %1").arg(output[299])));
+
+        // Converge to a constant input
+        for(int i{0}; i < 20; i++) {
+            smoother.apply(samples.constData(), samples.size(), output.data());
+        }
+        QVERIFY2(output[0] == 200 && output[199] == 200,
+                 qPrintable(QString("Filter did not converge: %1").arg(output[0])));
+    }
+}
+
+void Test::waterfallPyramid()
+{
+    const int capacity = 16;
+    const int columnLength = 10;
+    WaterfallPyramid pyramid(capacity, columnLength);
+
+    // A thin target in a single profile should be kept in all levels, it is in the oldest column of the first level
+    QVector<uint8_t> profile(columnLength, 0);
+    const int profiles = WaterfallPyramid::decimation(WaterfallPyramid::levels - 1)*2;
+    const int target = profiles - capacity;
+    for(int i{0}; i < profiles; i++) {
+        profile[5] = i == target ? 255 : 0;
+        pyramid.append(profile.constData(), profile.size(), {1, 10});
+    }
+
+    for(int level{0}; level < WaterfallPyramid::levels; level++) {
+        const int decimation = WaterfallPyramid::decimation(level);
+        QVERIFY2(pyramid.count(level) == uint32_t(profiles/decimation),
+                 qPrintable(QString("Wrong number of columns in level %1: %2").arg(level).arg(pyramid.count(level))));
+
+        // Memory is bounded by the capacity
+        const WaterfallHistory& history = pyramid.level(level);
+        QVERIFY2(history.size() == qMin(capacity, profiles/decimation),
+                 qPrintable(QString("Wrong size in level %1: %2").arg(level).arg(history.size())));
+
+        // The target column is found from its age, the newest column has age 0
+        const int age = profiles/decimation - 1 - target/decimation;
+        QVERIFY2(age >= 0 && age < history.size(),
+                 qPrintable(QString("Target column out of range in level %1: %2").arg(level).arg(age)));
+        QVERIFY2(history.value(age, 6.5) == 255, qPrintable(QString("Target lost in level %1").arg(level)));
+    }
+
+    // Columns with different depth ranges are merged
+    pyramid.clear();
+    for(int i{0}; i < WaterfallPyramid::groupSize; i++) {
+        profile.fill(i*10);
+        pyramid.append(profile.constData(), profile.size(), {float(i), 10});
+    }
+    const auto& info = pyramid.level(1).info(0);
+    QVERIFY2(qFuzzyCompare(info.initialDepth + 1, 1.0f) && qFuzzyCompare(info.length, 13.0f),
+             qPrintable(QString("Wrong merged range: %1 %2").arg(info.initialDepth).arg(info.length)));
+    QVERIFY2(pyramid.level(1).value(0, 12.5) == 30 && pyramid.level(1).value(0, 0.5) == 0,
+             qPrintable(QString("Wrong merged values: %1 %2")
+                        .arg(pyramid.level(1).value(0, 12.5)).arg(pyramid.level(1).value(0, 0.5))));
+}
+
+void Test::waterfallProfileSink()
+{
+    Waterfall waterfall;
+    ProfileSink* sink = qobject_cast<ProfileSink*>(&waterfall);
+    QVERIFY(sink);
+
+    // Without a window the profile is added to the history immediately
+    const Profile::Pointer profile(new Profile(QByteArray(200, char(255)), 100, 1, 10, 5));
+    sink->appendProfile(profile);
+    QCOMPARE(waterfall.historySize(), 1);
+    QCOMPARE(waterfall._history.level(0).value(0, 5), 255);
+    QVERIFY(waterfall._pendingProfiles.isEmpty());
+
+    // Invalid profiles are ignored
+    sink->appendProfile(Profile::Pointer(new Profile(QByteArray(200, char(255)), 100, 65, 10, 5)));
+    QCOMPARE(waterfall.historySize(), 1);
+
+    // Longer profiles are resampled without losing thin targets
+    QByteArray samples(1000, 0);
+    samples[501] = char(200);
+    sink->appendProfile(Profile::Pointer(new Profile(samples, 100, 0, 10, 5)));
+    QCOMPARE(waterfall.historySize(), 2);
+    QCOMPARE(waterfall._history.level(0).value(0, 5.01), 200);
+
+    // A window that is not exposed does not polish, the pending profiles are limited to the display width
+    QQuickWindow window;
+    waterfall.setParentItem(window.contentItem());
+    for(int i{0}; i < 2*Waterfall::displayWidth; i++) {
+        sink->appendProfile(profile);
+    }
+    QVERIFY(waterfall._pendingProfiles.size() < Waterfall::displayWidth);
+    QCOMPARE(waterfall.historySize(), 2 + 2*Waterfall::displayWidth - waterfall._pendingProfiles.size());
+    waterfall.setParentItem(nullptr);
+}
+
+void Test::bufferPool()
+{
+    BufferPool pool(4, 2);
+    const QByteArray data(300, char(7));
+
+    // Released buffers are reused
+    const char* address = nullptr;
+    for(int i{0}; i < 10; i++) {
+        const QByteArray buffer = pool.copy(data.constData(), data.length());
+        QCOMPARE(buffer, data);
+        QVERIFY(!address || address == buffer.constData());
+        address = buffer.constData();
+    }
+    QCOMPARE(pool.size(), 1);
+
+    // Buffers in use are not overwritten
+    QVector<QByteArray> buffers;
+    for(int i{0}; i < 6; i++) {
+        const QByteArray value(300, char(i));
+        buffers.append(pool.copy(value.constData(), value.length()));
+    }
+    for(int i{0}; i < buffers.size(); i++) {
+        QCOMPARE(buffers[i], QByteArray(300, char(i)));
+    }
+    QCOMPARE(pool.size(), 4);
+
+    // Each length has its own buffers
+    QCOMPARE(pool.copy(data.constData(), 100).length(), 100);
+    QCOMPARE(pool.size(), 5);
+    QVERIFY(pool.copy(nullptr, 10).isEmpty());
+
+    // Only the most recently used lengths are kept
+    QCOMPARE(pool.copy(data.constData(), 200).length(), 200);
+    QCOMPARE(pool.size(), 2);
+    pool.copy(data.constData(), 100);
+    pool.copy(data.constData(), 300);
+    QCOMPARE(pool.size(), 2);
+    QCOMPARE(pool._lengths, QVector<int>({100, 300}));
+}
+
+void Test::pingDispatchBenchmark_data()
+{
+    QTest::addColumn<QByteArray>("message");
+
+    ping_msg_ping1D_profile profile(200);
+    profile.set_distance(5000);
+    profile.set_confidence(100);
+    profile.set_scan_length(10000);
+    profile.set_profile_data_length(200);
+    for(int i{0}; i < 200; i++) {
+        profile.set_profile_data_at(i, i);
+    }
+    profile.updateChecksum();
+    QTest::newRow("profile") << QByteArray(reinterpret_cast<const char*>(profile.msgData), profile.msgDataLength());
+
+    ping_msg_ping1D_distance_simple distance;
+    distance.set_distance(5000);
+    distance.set_confidence(100);
+    distance.updateChecksum();
+    QTest::newRow("distance_simple")
+            << QByteArray(reinterpret_cast<const char*>(distance.msgData), distance.msgDataLength());
+}
+
+void Test::pingDispatchBenchmark()
+{
+    QFETCH(QByteArray, message);
+
+    Ping ping(false);
+    const uint8_t* data = reinterpret_cast<const uint8_t*>(message.constData());
+    static const int messagesPerRun = 10000;
+
+    QBENCHMARK {
+        for(int i{0}; i < messagesPerRun; i++) {
+            ping.handleMessage(data, message.length());
+        }
+        ping.flushPropertyUpdates();
+    }
+
+    QCOMPARE(ping.distance(), 5000u);
+}
+
+void Test::pingProfileBounds()
+{
+    Ping ping(false);
+    ping_msg_ping1D_profile profile(200);
+    profile.set_profile_data_length(200);
+    profile.set_distance(1000);
+    profile.updateChecksum();
+    ping.handleMessage(profile.msgData, profile.msgDataLength());
+    QCOMPARE(ping.points().length(), 200);
+    QCOMPARE(ping.distance(), 1000u);
+
+    // The frame is valid, but the sample count is bigger than the payload
+    profile.set_profile_data_length(1000);
+    profile.set_distance(2000);
+    profile.updateChecksum();
+    ping.handleMessage(profile.msgData, profile.msgDataLength());
+    QCOMPARE(ping.points().length(), 200);
+    QCOMPARE(ping.distance(), 1000u);
+
+    // The header can't claim more bytes than the message
+    profile.set_profile_data_length(200);
+    profile.updateChecksum();
+    ping.handleMessage(profile.msgData, profile.msgDataLength() - 1);
+    QCOMPARE(ping.distance(), 1000u);
+}
+
+void Test::pingFrameParser()
+{
+    // Valid frames between noise, a corrupted frame and a fake sync, starting with a fake sync that claims a payload
+    // bigger than maxPayloadLength
+    QByteArray stream("BR\xff\xffnoise");
+    QVector<int> ids;
+    for(int id : {Ping1DNamespace::Firmware_version, Ping1DNamespace::Distance, Ping1DNamespace::Profile}) {
+        ping_msg_ping1D_empty message;
+        message.set_id(id);
+        message.updateChecksum();
+        QByteArray frame(reinterpret_cast<const char*>(message.msgData), message.msgDataLength());
+        if(ids.isEmpty()) {
+            // Fake header with a valid length whose payload covers the first frame, the checksum can't match since
+            // the sum of a few bytes is never 0xffff, the first frame has to be recovered by the rescan
+            const QByteArray noise("noise!");
+            const int payloadLength = frame.length() + noise.length();
+            QByteArray fakeHeader(PingFrameParser::headerLength, '\0');
+            fakeHeader[0] = 'B';
+            fakeHeader[1] = 'R';
+            fakeHeader[2] = static_cast<char>(payloadLength & 0xff);
+            fakeHeader[3] = static_cast<char>(payloadLength >> 8);
+            stream += fakeHeader + frame + noise + "\xff\xff" + "BR";
+        } else {
+            stream += frame + "BR";
+        }
+        ids.append(id);
+
+        frame[4] = frame[4] + 1;
+        stream += frame;
+    }
+
+    for(int chunkSize : {1, 3, 7, stream.length()}) {
+        QVector<int> parsedIds;
+        PingFrameParser parser([&parsedIds](const uint8_t* data, int length) {
+            QVERIFY(length >= PingFrameParser::headerLength + PingFrameParser::checksumLength);
+            parsedIds.append(data[4] | data[5] << 8);
+        });
+
+        int frames = 0;
+        for(int i{0}; i < stream.length(); i += chunkSize) {
+            frames += parser.parse(stream.mid(i, chunkSize));
+        }
+
+        QCOMPARE(parsedIds, ids);
+        QCOMPARE(frames, ids.length());
+        QCOMPARE(parser.parsed(), ids.length());
+        // Both fake syncs, and the fake sync and corrupted frame after each valid frame
+        QVERIFY2(parser.errors() >= 2 + 2*ids.length(), qPrintable(QString("Chunk size: %1").arg(chunkSize)));
+    }
+}
+
+void Test::checksum()
+{
+    QVector<uint8_t> data(5000);
+    for(int i{0}; i < data.size(); i++) {
+        data[i] = static_cast<uint8_t>(qrand());
+    }
+
+    // Different alignments and lengths around the vector size
+    for(int offset{0}; offset < 16; offset++) {
+        for(int length{0}; length < 300; length++) {
+            const uint8_t* begin = data.constData() + offset;
+            QCOMPARE(Checksum::sum(begin, length), Checksum::sumScalar(begin, length));
+        }
+    }
+    QCOMPARE(Checksum::sum(data.constData(), data.size()), Checksum::sumScalar(data.constData(), data.size()));
+
+    // The shared routine matches the ping message implementation
+    ping_msg_ping1D_distance_simple message;
+    message.set_distance(1234);
+    message.set_confidence(99);
+    message.updateChecksum();
+    const QByteArray expected(reinterpret_cast<const char*>(message.msgData), message.msgDataLength());
+    PingFrameParser::updateChecksum(message.msgData, message.msgDataLength());
+    QCOMPARE(QByteArray(reinterpret_cast<const char*>(message.msgData), message.msgDataLength()), expected);
+}
+
+void Test::checksumBenchmark_data()
+{
+    QTest::addColumn<bool>("vector");
+    QTest::addColumn<QVector<int>>("frameSizes");
+
+    // Requests, distance messages and profiles with different number of samples
+    const QVector<int> mixed{10, 10, 10, 24, 24, 24, 224, 224, 1214};
+    for(bool vector : {false, true}) {
+        const QString kernel = vector ? "vector" : "scalar";
+        QTest::newRow(qPrintable(kernel + " request")) << vector << QVector<int>{10};
+        QTest::newRow(qPrintable(kernel + " distance")) << vector << QVector<int>{24};
+        QTest::newRow(qPrintable(kernel + " profile 200")) << vector << QVector<int>{224};
+        QTest::newRow(qPrintable(kernel + " profile 1200")) << vector << QVector<int>{1214};
+        QTest::newRow(qPrintable(kernel + " mixed")) << vector << mixed;
+    }
+}
+
+void Test::checksumBenchmark()
+{
+    QFETCH(bool, vector);
+    QFETCH(QVector<int>, frameSizes);
+
+    QVector<uint8_t> data(2048);
+    std::iota(data.begin(), data.end(), 0);
+
+    uint16_t sum = 0;
+    QBENCHMARK {
+        for(int i{0}; i < 1000; i++) {
+            const int size = frameSizes[i%frameSizes.size()];
+            // Frames are not aligned in the receive buffer
+            const uint8_t* frame = data.constData() + i%16;
+            sum += vector ? Checksum::sum(frame, size) : Checksum::sumScalar(frame, size);
+        }
+    }
+    Q_UNUSED(sum)
+}
+
+void Test::requestScheduler()
+{
+    QVector<int> sent;
+    RequestScheduler scheduler([&sent](int id) { sent.append(id); });
+    scheduler.setMaxInFlight(2);
+    scheduler.setTimeout(50);
+    scheduler.setMaxRetries(1);
+
+    // Only two requests are sent, the same id is not queued twice
+    scheduler.request(1, RequestScheduler::Housekeeping);
+    scheduler.request(2, RequestScheduler::Housekeeping);
+    scheduler.request(3, RequestScheduler::Housekeeping);
+    scheduler.request(3, RequestScheduler::Housekeeping);
+    scheduler.request(4, RequestScheduler::Streaming);
+    scheduler.request(5, RequestScheduler::Configuration);
+    QCOMPARE(sent, QVector<int>({1, 2}));
+    QCOMPARE(scheduler.inFlight(), 2);
+    QCOMPARE(scheduler.pending(), 3);
+
+    // Replies release the queue by priority
+    scheduler.replied(1);
+    scheduler.replied(2);
+    QCOMPARE(sent, QVector<int>({1, 2, 4, 5}));
+    QCOMPARE(scheduler.statistics(1).replies, 1);
+
+    // Unknown replies are ignored
+    scheduler.replied(42);
+    QCOMPARE(scheduler.inFlight(), 2);
+
+    // Requests without reply are sent again and lost after all retries
+    scheduler.replied(4);
+    QCOMPARE(sent.last(), 3);
+    QTRY_COMPARE_WITH_TIMEOUT(scheduler.lostRequests(), 2, 1000);
+    QCOMPARE(sent.count(3), 2);
+    QCOMPARE(sent.count(5), 2);
+    QCOMPARE(scheduler.statistics(3).timeouts, 2);
+    QCOMPARE(scheduler.statistics(3).retries, 1);
+    QCOMPARE(scheduler.inFlight(), 0);
+    QCOMPARE(scheduler.pending(), 0);
+
+    // Housekeeping slows down and waits while the link is busy
+    scheduler.setLinkCapacity(1000);
+    QCOMPARE(scheduler.housekeepingInterval(), 1000);
+    scheduler._receivedRate = 900;
+    QVERIFY(scheduler.housekeepingInterval() > 1000);
+    scheduler.request(6, RequestScheduler::Housekeeping);
+    QCOMPARE(scheduler.pending(), 1);
+    scheduler.request(7, RequestScheduler::Streaming);
+    QCOMPARE(sent.last(), 7);
+    scheduler.clear();
+    QCOMPARE(scheduler.pending(), 0);
+
+    // On slow links the timeout includes the time to receive the replies, 9600 bauds receive 960 bytes per second
+    scheduler.setLinkCapacity(960);
+    scheduler.request(8, RequestScheduler::Streaming);
+    scheduler.replied(8, -1, 1214);
+    QCOMPARE(scheduler.replyTimeout(8), 50 + 1214*1000/960);
+    scheduler.request(8, RequestScheduler::Streaming);
+    QCOMPARE(sent.count(8), 2);
+    QCOMPARE(scheduler.inFlight(), 1);
+
+    // The request is moved back in time, it times out only after the time to receive the reply
+    scheduler._inFlight[0].sentTime -= 200*1000000LL;
+    scheduler.checkTimeouts();
+    QCOMPARE(scheduler.statistics(8).timeouts, 0);
+    QCOMPARE(scheduler.inFlight(), 1);
+    scheduler._inFlight[0].sentTime -= 2000*1000000LL;
+    scheduler.checkTimeouts();
+    QCOMPARE(scheduler.statistics(8).timeouts, 1);
+    QCOMPARE(scheduler.inFlight(), 0);
+    scheduler.clear();
+}
+
+void Test::latencyStatistics()
+{
+    LatencyHistogram histogram;
+    QCOMPARE(histogram.valueAtPercentile(50), qint64(0));
+    for(int i{1}; i <= 1000; i++) {
+        histogram.record(i*1000);
+    }
+    QCOMPARE(histogram.count(), qint64(1000));
+    QCOMPARE(histogram.min(), qint64(1000));
+    QCOMPARE(histogram.max(), qint64(1000000));
+    QCOMPARE(histogram.mean(), 500500.0);
+
+    // Buckets keep ~3% of precision
+    for(const double percentile : {10.0, 50.0, 90.0, 99.0}) {
+        const qint64 expected = percentile*10000;
+        QVERIFY(histogram.valueAtPercentile(percentile) >= expected);
+        QVERIFY(histogram.valueAtPercentile(percentile) <= expected*1.04);
+    }
+    QCOMPARE(histogram.valueAtPercentile(100), qint64(1000000));
+
+    // Out of range values are clamped
+    histogram.clear();
+    histogram.record(-1);
+    histogram.record(std::numeric_limits<qint64>::max());
+    QCOMPARE(histogram.min(), qint64(0));
+    QCOMPARE(histogram.max(), qint64(60000000));
+
+    // Profiles with a constant interval have no jitter
+    ping_msg_ping1D_profile profile(200);
+    profile.set_profile_data_length(200);
+    profile.updateChecksum();
+    Ping ping(false);
+    for(int i{0}; i < 10; i++) {
+        ping.handleMessage(profile.msgData, profile.msgDataLength(), i*100000000LL);
+    }
+    QCOMPARE(ping._profileIntervals.count(), qint64(9));
+    QCOMPARE(ping._profileIntervals.valueAtPercentile(50), qint64(100000));
+    QCOMPARE(ping.profileJitter(), 0.0f);
+
+    // A late profile changes two intervals
+    ping.handleMessage(profile.msgData, profile.msgDataLength(), 1050000000LL);
+    ping.handleMessage(profile.msgData, profile.msgDataLength(), 1100000000LL);
+    QVERIFY(ping.profileJitter() > 0);
+
+    QTemporaryFile file;
+    QVERIFY(file.open());
+    QVERIFY(ping.dumpLatencyStatistics(file.fileName()));
+    QVERIFY(file.readAll().contains("# Profile interval"));
+}
+
+void Test::sensorLog()
+{
+    QTemporaryFile file;
+    QVERIFY(file.open());
+
+    LogWriter writer;
+    QVERIFY(writer.begin(&file));
+    for(int i{0}; i < 100; i++) {
+        QVERIFY(writer.write(QByteArray(i, static_cast<char>(i)), i%2, i*1000000LL));
+    }
+    QVERIFY(writer.finish());
+    QVERIFY(!writer.isActive());
+
+    // Records are found with the index
+    LogReader reader;
+    QVERIFY(reader.open(&file));
+    QVERIFY(reader.hasIndex());
+    QVERIFY(reader.isMapped());
+    QCOMPARE(reader.version(), 1);
+    QVERIFY(reader.startTime().isValid());
+    QCOMPARE(reader.size(), 100);
+    for(int i{0}; i < reader.size(); i++) {
+        QCOMPARE(reader.record(i).timestamp, i*1000000LL);
+        QCOMPARE(reader.record(i).linkId, static_cast<quint16>(i%2));
+        QCOMPARE(reader.data(i), QByteArray(i, static_cast<char>(i)));
+    }
+
+    // Logs that were not finished are read record by record, the incomplete record is ignored
+    const qint64 lastRecordEnd = reader.record(99).offset + 99;
+    reader.close();
+
+    // An index entry outside the records is not used, the log needs to be indexed
+    QDataStream indexStream(&file);
+    indexStream.setByteOrder(QDataStream::LittleEndian);
+    quint64 indexOffset;
+    file.seek(LogFormat::indexOffsetPosition);
+    indexStream >> indexOffset;
+    file.seek(indexOffset + LogFormat::indexHeaderSize + 8);
+    indexStream << std::numeric_limits<quint64>::max();
+    file.flush();
+    QVERIFY(reader.open(&file));
+    QVERIFY(!reader.hasIndex());
+    QCOMPARE(reader.size(), 0);
+    reader.close();
+
+    file.resize(lastRecordEnd - 1);
+    file.seek(LogFormat::indexOffsetPosition);
+    QDataStream(&file) << quint64(0);
+    QVERIFY(reader.open(&file));
+    QVERIFY(!reader.hasIndex());
+    QVERIFY(!reader.isIndexed());
+    QCOMPARE(reader.size(), 0);
+    reader.index();
+    QVERIFY(reader.isIndexed());
+    QCOMPARE(reader.size(), 99);
+    QCOMPARE(reader.data(98), QByteArray(98, static_cast<char>(98)));
+
+    // The index is cached for the next time
+    QTemporaryDir cacheDir;
+    const QString cacheFileName = cacheDir.filePath("log.index");
+    QVERIFY(reader.saveIndex(cacheFileName));
+    QVERIFY(reader.open(&file));
+    QVERIFY(reader.loadIndex(cacheFileName));
+    QVERIFY(reader.isIndexed());
+    QCOMPARE(reader.size(), 99);
+    QCOMPARE(reader.record(98).timestamp, 98000000LL);
+    QCOMPARE(reader.data(98), QByteArray(98, static_cast<char>(98)));
+
+    // A cache with offsets outside the records is not used
+    QFile cache(cacheFileName);
+    QVERIFY(cache.open(QIODevice::ReadWrite));
+    cache.seek(LogFormat::indexCacheHeaderSize + 8);
+    QDataStream(&cache) << std::numeric_limits<quint64>::max();
+    cache.close();
+    QVERIFY(reader.open(&file));
+    QVERIFY(!reader.loadIndex(cacheFileName));
+    QVERIFY(!reader.isIndexed());
+
+    // The indexer delivers records in chunks with the progress
+    QVector<int> chunks;
+    QVector<float> progress;
+    LogIndexer indexer(reader.contents(), reader.indexBegin(), reader.indexEnd(), reader.version());
+    indexer.setRecordsHandler([&](const QVector<LogFormat::Record>& records, float chunkProgress) {
+        chunks.append(records.size());
+        progress.append(chunkProgress);
+    });
+    QSignalSpy finishedSpy(&indexer, &LogIndexer::finished);
+    indexer.run();
+    QCOMPARE(chunks, QVector<int>({99}));
+    QCOMPARE(progress, QVector<float>({1}));
+    QCOMPARE(finishedSpy.count(), 1);
+
+    // Previous format with time strings, the time goes back after midnight
+    QTemporaryFile legacyFile;
+    QVERIFY(legacyFile.open());
+    QDataStream stream(&legacyFile);
+    stream << QString("23:59:59.500") << QByteArray("a") << QString("00:00:00.250") << QByteArray("b");
+    QVERIFY(reader.open(&legacyFile));
+    QCOMPARE(reader.version(), 0);
+    reader.index();
+    QCOMPARE(reader.size(), 2);
+    QCOMPARE(reader.record(1).timestamp, 750000000LL);
+    QCOMPARE(reader.data(1), QByteArray("b"));
+
+    // Version 0 is only used by the previous format, it's not valid with the header
+    file.seek(LogFormat::magicSize);
+    QDataStream(&file) << quint16(0);
+    file.flush();
+    QVERIFY(!reader.open(&file));
+
+    // Logs can be longer than a day
+    QTemporaryFile longFile;
+    QVERIFY(longFile.open());
+    LogWriter longWriter;
+    QVERIFY(longWriter.begin(&longFile));
+    QVERIFY(longWriter.write(QByteArray("a"), 0, 0));
+    QVERIFY(longWriter.write(QByteArray("b"), 0, 25*3600*1000000000LL));
+    QVERIFY(longWriter.finish());
+    QVERIFY(reader.open(&longFile));
+    LogThread logThread;
+    logThread.setReader(&reader);
+    QCOMPARE(logThread.totalMSecs(), 25*3600*1000LL);
+}
+
+void Test::sensorLogSeek()
+{
+    QTemporaryFile file;
+    QVERIFY(file.open());
+
+    // A package each 10ms
+    LogWriter writer;
+    QVERIFY(writer.begin(&file));
+    for(int i{0}; i < 1000; i++) {
+        QVERIFY(writer.write(QByteArray(1, static_cast<char>(i)), 0, i*10000000LL));
+    }
+    QVERIFY(writer.finish());
+
+    LogReader reader;
+    QVERIFY(reader.open(&file));
+    QCOMPARE(reader.indexAt(-1), 0);
+    QCOMPARE(reader.indexAt(0), 0);
+    QCOMPARE(reader.indexAt(5000000), 1);
+    QCOMPARE(reader.indexAt(9990000000LL), 999);
+    QCOMPARE(reader.indexAt(9990000001LL), 1000);
+
+    // Packages before the seek point are sent again without waiting
+    LogThread logThread;
+    logThread.setReader(&reader);
+    logThread.pauseJob();
+    QSignalSpy seekedSpy(&logThread, &LogThread::seeked);
+    QSignalSpy packageSpy(&logThread, &LogThread::newPackage);
+    logThread.seek(8005);
+    QCOMPARE(seekedSpy.count(), 1);
+    QCOMPARE(seekedSpy.at(0).at(0).toInt(), 801 - LogThread::preRollPackages);
+    QCOMPARE(seekedSpy.at(0).at(1).toInt(), 801);
+    // The pre-roll is sent in batches, the elapsed time is already the one of the seek
+    QCOMPARE(logThread.elapsedMSecs(), qint64(8010));
+    QTRY_COMPARE(packageSpy.count(), LogThread::preRollPackages);
+    QCOMPARE(packageSpy.last().at(0).toByteArray(), QByteArray(1, static_cast<char>(800)));
+    QCOMPARE(logThread.packageIndex(), 801);
+    QCOMPARE(logThread.elapsedMSecs(), qint64(8010));
+    QVERIFY(!logThread.isActive());
+
+    // The pre-roll stops in the first package and seeks after the end go to the last package
+    logThread.seek(100);
+    QCOMPARE(seekedSpy.last().at(0).toInt(), 0);
+    QCOMPARE(packageSpy.count(), LogThread::preRollPackages + 10);
+    logThread.seek(20000);
+    QTRY_COMPARE(logThread.packageIndex(), 999);
+
+    // The pre-roll waits for the receiver, so a seek does not overflow the receiver queue
+    logThread.receiverReady();
+    packageSpy.clear();
+    logThread.seek(8005);
+    QTest::qWait(50);
+    QCOMPARE(packageSpy.count(), LogThread::maxPendingPackages);
+    logThread.receiverReady();
+    QTRY_COMPARE(packageSpy.count(), LogThread::preRollPackages);
+    QCOMPARE(logThread.packageIndex(), 801);
+
+    // Ping saves keyframes while the log is played and restores them when seeking
+    Waterfall waterfall;
+    Ping ping(false);
+    ping.addProfileSink(&waterfall);
+    ping_msg_ping1D_profile profile(200);
+    profile.set_profile_data_length(200);
+    for(int i{0}; i < 300; i++) {
+        profile.set_scan_length(1000 + i);
+        profile.updateChecksum();
+        QVERIFY(ping._messageQueue.push({QByteArray(reinterpret_cast<const char*>(profile.msgData),
+                                          profile.msgDataLength()), i, i}));
+    }
+    ping.handleQueuedMessages();
+    QCOMPARE(ping.length_mm(), 1299u);
+    QCOMPARE(ping._keyframes.keys(), QList<int>({99, 199, 299}));
+    QCOMPARE(waterfall.historySize(), 300);
+
+    QVERIFY(ping._messageQueue.push({QByteArray(), 0, 150, 250}));
+    ping.handleQueuedMessages();
+    QCOMPARE(ping.length_mm(), 1099u);
+    QCOMPARE(ping._seekIndex, 250);
+    QCOMPARE(waterfall.historySize(), 0);
+
+    // Long logs keep every other keyframe and save the next ones with a bigger spacing
+    ping._keyframes.clear();
+    for(int i{0}; i <= Ping::_maxKeyframes; i++) {
+        ping._packageIndex = i;
+        ping.saveKeyframe();
+    }
+    QCOMPARE(ping._keyframes.size(), Ping::_maxKeyframes/2 + 1);
+    QCOMPARE(ping._keyframes.firstKey(), 0);
+    QCOMPARE(ping._keyframes.lastKey(), Ping::_maxKeyframes);
+    QCOMPARE(ping._keyframeSpacing, 2*Ping::_keyframeInterval);
+}
+
+void Test::sensorLogPlayback()
+{
+    QTemporaryFile file;
+    QVERIFY(file.open());
+
+    // A package each 10ms
+    LogWriter writer;
+    QVERIFY(writer.begin(&file));
+    for(int i{0}; i < 1000; i++) {
+        QVERIFY(writer.write(QByteArray(1, static_cast<char>(i)), 0, i*10000000LL));
+    }
+    QVERIFY(writer.finish());
+
+    LogReader reader;
+    QVERIFY(reader.open(&file));
+    LogThread logThread;
+    logThread.setReader(&reader);
+    logThread.pauseJob();
+
+    QSignalSpy speedSpy(&logThread, &LogThread::speedChanged);
+    logThread.setSpeed(1000);
+    QCOMPARE(logThread.speed(), LogThread::maxSpeedFactor);
+    logThread.setSpeed(0);
+    QCOMPARE(logThread.speed(), LogThread::minSpeedFactor);
+    QCOMPARE(speedSpy.count(), 2);
+
+    // 100x plays the 10s log in 100ms, the timer resolution does not limit the package rate
+    // No package is sent before its time in the log clock, that runs with the speed factor
+    // Package index notifications are limited to the display rate
+    logThread.setSpeed(100);
+    QSignalSpy packageSpy(&logThread, &LogThread::newPackage);
+    QSignalSpy indexSpy(&logThread, &LogThread::packageIndexChanged);
+    int earlyPackages = 0;
+    const auto clockConnection = connect(&logThread, &LogThread::newPackage, this, [&logThread, &earlyPackages] {
+        if(logThread.timestamp(logThread.packageIndex()) > logThread.playbackTimestamp()) {
+            earlyPackages++;
+        }
+    });
+    logThread.startJob();
+    QTRY_COMPARE_WITH_TIMEOUT(packageSpy.count(), 1000, 10000);
+    disconnect(clockConnection);
+    QCOMPARE(earlyPackages, 0);
+    QCOMPARE(logThread.elapsedMSecs(), qint64(9990));
+    QVERIFY(logThread.playbackTimestamp() >= logThread.timestamp(999));
+    QTRY_VERIFY(indexSpy.count() > 0);
+    QVERIFY(indexSpy.count() < 100);
+    QCOMPARE(packageSpy.last().at(0).toByteArray(), QByteArray(1, static_cast<char>(999)));
+
+    // Max speed waits for the receiver, so a receiver that can't keep up does not lose packages
+    logThread.pauseJob();
+    logThread.receiverReady();
+    logThread.setMaxSpeed(true);
+    QVERIFY(logThread.isMaxSpeed());
+    logThread.setPackageIndex(0);
+    packageSpy.clear();
+    logThread.startJob();
+    QTRY_COMPARE(packageSpy.count(), LogThread::maxPendingPackages);
+    for(int i{0}; i < 10; i++) {
+        QCoreApplication::processEvents();
+    }
+    QCOMPARE(packageSpy.count(), LogThread::maxPendingPackages);
+
+    // Each receiverReady releases the next batch
+    for(int batch{1}; batch*LogThread::maxPendingPackages < 1000; batch++) {
+        logThread.receiverReady();
+        QTRY_COMPARE(packageSpy.count(), qMin(1000, (batch + 1)*LogThread::maxPendingPackages));
+    }
+    QTRY_COMPARE_WITH_TIMEOUT(packageSpy.count(), 1000, 10000);
+    for(int i{0}; i < packageSpy.count(); i++) {
+        QCOMPARE(packageSpy.at(i).at(0).toByteArray(), QByteArray(1, static_cast<char>(i)));
+    }
 }
 
 QTEST_MAIN(Test)
\ No newline at end of file
@@ -32,9 +32,114 @@ private slots:
      */
     void settingsManager();
 
+    /**
+     * @brief Test single producer single consumer queue
+     *
+     */
+    void spscQueue();
+
     /**
      * @brief Test waterfall gradient
      *
      */
     void waterfallGradient();
+
+    /**
+     * @brief Test column kernel SIMD version against the scalar one
+     *
+     */
+    void columnKernel();
+
+    /**
+     * @brief Benchmark column kernel against the previous per row loop
+     *
+     */
+    void columnKernelBenchmark();
+    void columnKernelBenchmark_data();
+
+    /**
+     * @brief Test column smoother and its SIMD kernels
+     *
+     */
+    void columnSmoother();
+
+    /**
+     * @brief Test waterfall history pyramid
+     *
+     */
+    void waterfallPyramid();
+
+    /**
+     * @brief Test profiles sent to the waterfall as a ProfileSink
+     *
+     */
+    void waterfallProfileSink();
+
+    /**
+     * @brief Test buffer reuse in the buffer pool
+     *
+     */
+    void bufferPool();
+
+    /**
+     * @brief Benchmark number of messages handled by Ping each second
+     *
+     */
+    void pingDispatchBenchmark();
+    void pingDispatchBenchmark_data();
+
+    /**
+     * @brief Test that profiles with more samples than their payload are dropped
+     *
+     */
+    void pingProfileBounds();
+
+    /**
+     * @brief Test frame sync and split frames in the ping frame parser
+     *
+     */
+    void pingFrameParser();
+
+    /**
+     * @brief Test SIMD checksum against the scalar version
+     *
+     */
+    void checksum();
+
+    /**
+     * @brief Benchmark checksum with common frame sizes
+     *
+     */
+    void checksumBenchmark();
+    void checksumBenchmark_data();
+
+    /**
+     * @brief Test request priorities, in-flight limit, timeouts and retries
+     *
+     */
+    void requestScheduler();
+
+    /**
+     * @brief Test latency histogram precision and profile jitter
+     *
+     */
+    void latencyStatistics();
+
+    /**
+     * @brief Test binary sensor log writer, reader, indexer and index cache, including the previous format
+     *
+     */
+    void sensorLog();
+
+    /**
+     * @brief Test time seek in sensor logs and sensor state keyframes
+     *
+     */
+    void sensorLogSeek();
+
+    /**
+     * @brief Test log playback speed, max speed with flow control and package index notifications
+     *
+     */
+    void sensorLogPlayback();
 };
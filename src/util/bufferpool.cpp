@@ -0,0 +1,57 @@
+#include <cstring>
+
+#include "bufferpool.h"
+
+BufferPool::BufferPool(int buffersPerLength, int maxLengths)
+    : _buffersPerLength(buffersPerLength)
+    , _maxLengths(qMax(1, maxLengths))
+{
+}
+
+QByteArray BufferPool::copy(const void* data, int length)
+{
+    if(!data || length <= 0) {
+        return QByteArray();
+    }
+
+    // A new length releases the buffers of the least recently used one, buffers in use are still valid
+    const int lengthIndex = _lengths.lastIndexOf(length);
+    if(lengthIndex < 0) {
+        if(_lengths.size() >= _maxLengths) {
+            _buffers.remove(_lengths.takeFirst());
+        }
+        _lengths.append(length);
+    } else if(lengthIndex != _lengths.size() - 1) {
+        _lengths.move(lengthIndex, _lengths.size() - 1);
+    }
+
+    QVector<QByteArray>& buffers = _buffers[length];
+    for(auto& buffer : buffers) {
+        // Only the pool has a reference to this buffer, data() will not detach it
+        if(buffer.isDetached()) {
+            memcpy(buffer.data(), data, length);
+            return buffer;
+        }
+    }
+
+    QByteArray buffer(static_cast<const char*>(data), length);
+    if(buffers.size() < _buffersPerLength) {
+        buffers.append(buffer);
+    }
+    return buffer;
+}
+
+void BufferPool::clear()
+{
+    _lengths.clear();
+    _buffers.clear();
+}
+
+int BufferPool::size() const
+{
+    int size = 0;
+    for(const auto& buffers : _buffers) {
+        size += buffers.size();
+    }
+    return size;
+}
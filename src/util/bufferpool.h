@@ -0,0 +1,56 @@
+#pragma once
+
+#include <QByteArray>
+#include <QHash>
+#include <QVector>
+
+/**
+ * @brief Pool of reusable byte buffers grouped by length
+ *  Buffers are implicitly shared, a buffer returns to the pool automatically when all copies outside the pool
+ *  are released. In steady state, with a small number of different lengths, no memory is allocated.
+ *  Only the most recently used lengths are kept, the pool is bounded to maxLengths*buffersPerLength buffers.
+ *
+ */
+class BufferPool
+{
+public:
+    /**
+     * @brief Construct a new Buffer Pool object
+     *
+     * @param buffersPerLength maximum number of buffers kept for each length
+     * @param maxLengths maximum number of different lengths kept
+     */
+    BufferPool(int buffersPerLength = 16, int maxLengths = 4);
+
+    /**
+     * @brief Copy data to a buffer that is not used outside the pool and return it
+     *  The data is written before the buffer is shared, this avoids the detach of the returned copy.
+     *  If all buffers of this length are in use and the pool is full, a buffer that is not tracked by the pool
+     *  is returned.
+     *
+     * @param data
+     * @param length number of bytes
+     * @return QByteArray
+     */
+    QByteArray copy(const void* data, int length);
+
+    /**
+     * @brief Release all buffers kept by the pool
+     *
+     */
+    void clear();
+
+    /**
+     * @brief Return number of buffers kept by the pool
+     *
+     * @return int
+     */
+    int size() const;
+
+private:
+    int _buffersPerLength;
+    int _maxLengths;
+    // Lengths kept by the pool, the most recently used is the last one
+    QVector<int> _lengths;
+    QHash<int, QVector<QByteArray>> _buffers;
+};
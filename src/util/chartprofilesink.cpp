@@ -0,0 +1,76 @@
+#include <QTimer>
+
+#include "chartprofilesink.h"
+#include "util.h"
+
+ChartProfileSink::ChartProfileSink(QObject* parent)
+    : QObject(parent)
+    , _minDepthToDraw(0)
+    , _maxDepthToDraw(0)
+    , _updateScheduled(false)
+{
+}
+
+void ChartProfileSink::appendProfile(const Profile::Pointer& profile)
+{
+    _profile = profile;
+    scheduleUpdate();
+}
+
+void ChartProfileSink::setSeries(QtCharts::QAbstractSeries* series)
+{
+    _series = series;
+    scheduleUpdate();
+    emit seriesChanged();
+}
+
+void ChartProfileSink::setInverseSeries(QtCharts::QAbstractSeries* series)
+{
+    _inverseSeries = series;
+    scheduleUpdate();
+    emit inverseSeriesChanged();
+}
+
+void ChartProfileSink::setMinDepthToDraw(float depth)
+{
+    _minDepthToDraw = depth;
+    scheduleUpdate();
+    emit minDepthToDrawChanged();
+}
+
+void ChartProfileSink::setMaxDepthToDraw(float depth)
+{
+    _maxDepthToDraw = depth;
+    scheduleUpdate();
+    emit maxDepthToDrawChanged();
+}
+
+void ChartProfileSink::scheduleUpdate()
+{
+    if(_updateScheduled) {
+        return;
+    }
+
+    // All profiles handled in the same event loop iteration result in a single update
+    _updateScheduled = true;
+    QTimer::singleShot(0, this, &ChartProfileSink::updateSeries);
+}
+
+void ChartProfileSink::updateSeries()
+{
+    _updateScheduled = false;
+    if(!_profile || _maxDepthToDraw <= _minDepthToDraw) {
+        return;
+    }
+
+    const float initialDepth = _profile->initialDepth();
+    const float finalDepth = initialDepth + _profile->length();
+    if(_series) {
+        Util::self()->update(_series, _profile->samples(), initialDepth, finalDepth,
+                             _minDepthToDraw, _maxDepthToDraw, 1);
+    }
+    if(_inverseSeries) {
+        Util::self()->update(_inverseSeries, _profile->samples(), initialDepth, finalDepth,
+                             _minDepthToDraw, _maxDepthToDraw, -1);
+    }
+}
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <QObject>
+#include <QPointer>
+#include <QtCharts/QAbstractSeries>
+
+#include "profilesink.h"
+
+/**
+ * @brief Profile sink that plots the latest profile in two chart series
+ *  Profiles are received for every message, but the series are updated only once per event loop iteration
+ *  with the latest profile.
+ *
+ */
+class ChartProfileSink : public QObject, public ProfileSink
+{
+    Q_OBJECT
+    Q_INTERFACES(ProfileSink)
+public:
+    /**
+     * @brief Construct a new Chart Profile Sink object
+     *
+     * @param parent
+     */
+    ChartProfileSink(QObject* parent = nullptr);
+
+    /**
+     * @brief Keep the profile and schedule a series update
+     *
+     * @param profile
+     */
+    void appendProfile(const Profile::Pointer& profile) override;
+
+    /**
+     * @brief Series that receives the profile intensity
+     *
+     * @return QtCharts::QAbstractSeries*
+     */
+    QtCharts::QAbstractSeries* series() { return _series; };
+    void setSeries(QtCharts::QAbstractSeries* series);
+    Q_PROPERTY(QtCharts::QAbstractSeries* series READ series WRITE setSeries NOTIFY seriesChanged)
+
+    /**
+     * @brief Series that receives the negative profile intensity
+     *
+     * @return QtCharts::QAbstractSeries*
+     */
+    QtCharts::QAbstractSeries* inverseSeries() { return _inverseSeries; };
+    void setInverseSeries(QtCharts::QAbstractSeries* series);
+    Q_PROPERTY(QtCharts::QAbstractSeries* inverseSeries READ inverseSeries WRITE setInverseSeries
+               NOTIFY inverseSeriesChanged)
+
+    /**
+     * @brief Min depth of the chart in meters
+     *
+     * @return float
+     */
+    float minDepthToDraw() { return _minDepthToDraw; };
+    void setMinDepthToDraw(float depth);
+    Q_PROPERTY(float minDepthToDraw READ minDepthToDraw WRITE setMinDepthToDraw NOTIFY minDepthToDrawChanged)
+
+    /**
+     * @brief Max depth of the chart in meters
+     *
+     * @return float
+     */
+    float maxDepthToDraw() { return _maxDepthToDraw; };
+    void setMaxDepthToDraw(float depth);
+    Q_PROPERTY(float maxDepthToDraw READ maxDepthToDraw WRITE setMaxDepthToDraw NOTIFY maxDepthToDrawChanged)
+
+signals:
+    void seriesChanged();
+    void inverseSeriesChanged();
+    void minDepthToDrawChanged();
+    void maxDepthToDrawChanged();
+
+private:
+    Q_DISABLE_COPY(ChartProfileSink)
+
+    /**
+     * @brief Schedule a series update, multiple calls before the update are merged
+     *
+     */
+    void scheduleUpdate();
+
+    /**
+     * @brief Plot the latest profile
+     *
+     */
+    void updateSeries();
+
+    QPointer<QtCharts::QAbstractSeries> _series;
+    QPointer<QtCharts::QAbstractSeries> _inverseSeries;
+    float _minDepthToDraw;
+    float _maxDepthToDraw;
+    Profile::Pointer _profile;
+    bool _updateScheduled;
+};
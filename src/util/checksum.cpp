@@ -0,0 +1,52 @@
+#include "checksum.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define CHECKSUM_SSE2
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define CHECKSUM_NEON
+#include <arm_neon.h>
+#endif
+
+uint16_t Checksum::sumScalar(const uint8_t* data, int length)
+{
+    uint32_t sum = 0;
+    for(int i = 0; i < length; i++) {
+        sum += data[i];
+    }
+    return static_cast<uint16_t>(sum);
+}
+
+uint16_t Checksum::sum(const uint8_t* data, int length)
+{
+    if(!data || length <= 0) {
+        return 0;
+    }
+
+    int i = 0;
+    uint32_t sum = 0;
+#if defined(CHECKSUM_SSE2)
+    // Sum of absolute differences against zero adds 8 bytes in each 64 bits lane
+    const __m128i zero = _mm_setzero_si128();
+    __m128i accumulator = zero;
+    for(; i + 16 <= length; i += 16) {
+        const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+        accumulator = _mm_add_epi64(accumulator, _mm_sad_epu8(bytes, zero));
+    }
+    sum = static_cast<uint32_t>(_mm_cvtsi128_si32(accumulator))
+          + static_cast<uint32_t>(_mm_cvtsi128_si32(_mm_srli_si128(accumulator, 8)));
+#elif defined(CHECKSUM_NEON)
+    // Pairwise additions widen the bytes to 32 bits lanes
+    uint32x4_t accumulator = vdupq_n_u32(0);
+    for(; i + 16 <= length; i += 16) {
+        accumulator = vpadalq_u16(accumulator, vpaddlq_u8(vld1q_u8(data + i)));
+    }
+    sum = vgetq_lane_u32(accumulator, 0) + vgetq_lane_u32(accumulator, 1)
+          + vgetq_lane_u32(accumulator, 2) + vgetq_lane_u32(accumulator, 3);
+#endif
+
+    for(; i < length; i++) {
+        sum += data[i];
+    }
+    return static_cast<uint16_t>(sum);
+}
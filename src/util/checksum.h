@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstdint>
+
+/**
+ * @brief Checksum routines shared by the message parsers and builders
+ *  The SIMD versions are used with SSE2 (x86) and NEON (ARM), otherwise the scalar version is used.
+ *
+ */
+namespace Checksum
+{
+/**
+ * @brief Sum all bytes, truncated to 16 bits
+ *
+ * @param data
+ * @param length number of bytes
+ * @return uint16_t
+ */
+uint16_t sum(const uint8_t* data, int length);
+
+/**
+ * @brief Scalar version of sum, this is the fallback and reference implementation
+ *
+ * @param data
+ * @param length number of bytes
+ * @return uint16_t
+ */
+uint16_t sumScalar(const uint8_t* data, int length);
+}
@@ -0,0 +1,96 @@
+#include <cmath>
+
+#include "latencyhistogram.h"
+
+LatencyHistogram::LatencyHistogram(qint64 maxValue, int significantBits)
+    : _significantBits(qBound(1, significantBits, 16))
+    , _maxValue(qMax<qint64>(1, maxValue))
+    , _count(0)
+    , _min(0)
+    , _max(0)
+    , _sum(0)
+{
+    _counts.fill(0, index(_maxValue) + 1);
+}
+
+int LatencyHistogram::index(qint64 value) const
+{
+    /*
+        Values below 2^(significantBits + 1) have their own bucket, higher values lose the lower bits:
+            shift = msb - significantBits
+            index = shift*2^significantBits + (value >> shift)
+        Where value >> shift is always between 2^significantBits and 2^(significantBits + 1).
+    */
+    int msb = 0;
+    while(msb < 62 && (value >> (msb + 1))) {
+        msb++;
+    }
+    if(msb <= _significantBits) {
+        return static_cast<int>(value);
+    }
+
+    const int shift = msb - _significantBits;
+    return (shift << _significantBits) + static_cast<int>(value >> shift);
+}
+
+qint64 LatencyHistogram::highestValue(int index) const
+{
+    const int subBuckets = 1 << _significantBits;
+    if(index < 2*subBuckets) {
+        return index;
+    }
+
+    const int shift = index/subBuckets - 1;
+    const qint64 top = index - (shift << _significantBits);
+    return ((top + 1) << shift) - 1;
+}
+
+void LatencyHistogram::record(qint64 value)
+{
+    value = qBound<qint64>(0, value, _maxValue);
+    _counts[index(value)]++;
+
+    _min = _count ? qMin(_min, value) : value;
+    _max = qMax(_max, value);
+    _sum += value;
+    _count++;
+}
+
+void LatencyHistogram::clear()
+{
+    _counts.fill(0);
+    _count = 0;
+    _min = 0;
+    _max = 0;
+    _sum = 0;
+}
+
+qint64 LatencyHistogram::valueAtPercentile(double percentile) const
+{
+    if(!_count) {
+        return 0;
+    }
+
+    const qint64 target = qMax<qint64>(1, std::ceil(qBound(0.0, percentile, 100.0)/100.0*_count));
+    qint64 total = 0;
+    for(int i = 0; i < _counts.size(); i++) {
+        total += _counts[i];
+        if(total >= target) {
+            // The bucket value can not be higher than the recorded values
+            return qMin(highestValue(i), _max);
+        }
+    }
+    return _max;
+}
+
+void LatencyHistogram::writeDistribution(QTextStream& stream, double scale) const
+{
+    qint64 total = 0;
+    for(int i = 0; i < _counts.size(); i++) {
+        if(!_counts[i]) {
+            continue;
+        }
+        total += _counts[i];
+        stream << qMin(highestValue(i), _max)/scale << " " << 100.0*total/_count << " " << total << "\n";
+    }
+}
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <QTextStream>
+#include <QVector>
+
+/**
+ * @brief HDR-style histogram of latency values
+ *  Values are integers (E.g: microseconds) stored in log-linear buckets, each power of two is divided in
+ *  2^significantBits sub-buckets. This keeps a fixed relative precision (~3% with 5 bits) over the whole range,
+ *  with a small fixed memory size and constant time recording.
+ *
+ */
+class LatencyHistogram
+{
+public:
+    /**
+     * @brief Construct a new Latency Histogram object
+     *
+     * @param maxValue highest trackable value, higher values are recorded as maxValue
+     * @param significantBits number of bits used to divide each power of two
+     */
+    LatencyHistogram(qint64 maxValue = 60000000, int significantBits = 5);
+
+    /**
+     * @brief Record a value
+     *
+     * @param value negative values are recorded as 0
+     */
+    void record(qint64 value);
+
+    /**
+     * @brief Remove all values
+     *
+     */
+    void clear();
+
+    /**
+     * @brief Return number of recorded values
+     *
+     * @return qint64
+     */
+    qint64 count() const { return _count; };
+
+    /**
+     * @brief Return lowest recorded value
+     *
+     * @return qint64 0 if empty
+     */
+    qint64 min() const { return _count ? _min : 0; };
+
+    /**
+     * @brief Return highest recorded value
+     *
+     * @return qint64 0 if empty
+     */
+    qint64 max() const { return _max; };
+
+    /**
+     * @brief Return mean of recorded values
+     *
+     * @return double 0 if empty
+     */
+    double mean() const { return _count ? _sum/_count : 0; };
+
+    /**
+     * @brief Return the value below which a percentage of the recorded values fall
+     *  The value is the highest value of the bucket, with the histogram precision
+     *
+     * @param percentile between 0 and 100
+     * @return qint64 0 if empty
+     */
+    qint64 valueAtPercentile(double percentile) const;
+
+    /**
+     * @brief Write the percentile distribution, one line for each used bucket
+     *      value percentile count
+     *
+     * @param stream
+     * @param scale values are divided by scale, E.g: 1000 to write microseconds as milliseconds
+     */
+    void writeDistribution(QTextStream& stream, double scale = 1) const;
+
+private:
+    /**
+     * @brief Return the bucket index of a value
+     *
+     * @param value
+     * @return int
+     */
+    int index(qint64 value) const;
+
+    /**
+     * @brief Return the highest value of a bucket
+     *
+     * @param index
+     * @return qint64
+     */
+    qint64 highestValue(int index) const;
+
+    int _significantBits;
+    qint64 _maxValue;
+    QVector<quint32> _counts;
+    qint64 _count;
+    qint64 _min;
+    qint64 _max;
+    double _sum;
+};
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <atomic>
+
+#include <QVector>
+
+/**
+ * @brief Lock-free single producer single consumer queue
+ *  One thread can push and another thread can pop at the same time without locks.
+ *  The capacity is rounded up to the next power of two and all memory is allocated in the constructor.
+ *
+ * @tparam T
+ */
+template <typename T>
+class SpscQueue
+{
+public:
+    /**
+     * @brief Construct a new Spsc Queue object
+     *
+     * @param capacity maximum number of items in the queue
+     */
+    SpscQueue(int capacity = 1024)
+        : _head(0)
+        , _tail(0)
+    {
+        uint size = 1;
+        while(size < static_cast<uint>(qMax(capacity, 1))) {
+            size <<= 1;
+        }
+        _items.resize(size);
+        _mask = size - 1;
+    }
+
+    /**
+     * @brief Add a new item, should only be called by the producer thread
+     *
+     * @param item
+     * @return true if the item was added
+     * @return false if the queue is full
+     */
+    bool push(const T& item)
+    {
+        const uint tail = _tail.load(std::memory_order_relaxed);
+        if(tail - _head.load(std::memory_order_acquire) > _mask) {
+            return false;
+        }
+
+        _items[tail & _mask] = item;
+        _tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief Remove the oldest item, should only be called by the consumer thread
+     *
+     * @param item
+     * @return true if an item was removed
+     * @return false if the queue is empty
+     */
+    bool pop(T& item)
+    {
+        const uint head = _head.load(std::memory_order_relaxed);
+        if(head == _tail.load(std::memory_order_acquire)) {
+            return false;
+        }
+
+        // Move the item out, this releases shared data in the consumer thread
+        item = std::move(_items[head & _mask]);
+        _items[head & _mask] = T();
+        _head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief Return the number of items in the queue, it can be outdated when returned
+     *
+     * @return int
+     */
+    int size() const
+    {
+        return static_cast<int>(_tail.load(std::memory_order_acquire) - _head.load(std::memory_order_acquire));
+    }
+
+    /**
+     * @brief Return the maximum number of items in the queue
+     *
+     * @return int
+     */
+    int capacity() const
+    {
+        return static_cast<int>(_mask + 1);
+    }
+
+private:
+    Q_DISABLE_COPY(SpscQueue)
+
+    // Positions are not masked, the difference between them is the number of items
+    std::atomic<uint> _head;
+    std::atomic<uint> _tail;
+    uint _mask;
+    QVector<T> _items;
+};
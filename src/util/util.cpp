@@ -20,7 +20,7 @@ QStringList Util::serialPortList()
     return portNameList;
 }
 
-void Util::update(QtCharts::QAbstractSeries* series, const QVector<double>& points,
+void Util::update(QtCharts::QAbstractSeries* series, const QByteArray& samples,
                   const float initPos, const float finalPos,
                   const float minPoint, const float maxPoint,
                   const float multiplier)
@@ -28,7 +28,7 @@ void Util::update(QtCharts::QAbstractSeries* series, const QVector<double>& poin
     static const int numberOfPoints = 300;
 
     // Check inputs
-    if (!series && points.isEmpty()) {
+    if (!series && samples.isEmpty()) {
         qCDebug(util) << "Serie or vector not valid.";
         return;
     }
@@ -49,21 +49,20 @@ void Util::update(QtCharts::QAbstractSeries* series, const QVector<double>& poin
 
     // Start
     const int lastStartPoint = int(distPoints*(initPos-minPoint));
-    #pragma omp for
     for(int i = 0; i < lastStartPoint; i++) {
         realPoints << QPointF(i, 0);
     }
 
     // Data
     const int lastDataPoint = int((finalPos - initPos)*distPoints);
-    const float dataIndexScale = points.length()/((finalPos - initPos)*distPoints);
-    #pragma omp for
+    const float dataIndexScale = samples.length()/((finalPos - initPos)*distPoints);
+    const uint8_t* data = reinterpret_cast<const uint8_t*>(samples.constData());
+    const float sampleScale = multiplier/255.0f;
     for(int i = 0; i < lastDataPoint; i++) {
-        realPoints << QPointF(i + lastStartPoint, multiplier * points[i*dataIndexScale]);
+        realPoints << QPointF(i + lastStartPoint, sampleScale * data[static_cast<int>(i*dataIndexScale)]);
     }
 
     // Final
-    #pragma omp for
     for(int i = realPoints.length(); i < numberOfPoints; i++) {
         realPoints << QPointF(i, 0);
     }
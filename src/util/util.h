@@ -20,17 +20,18 @@ class Util : public QObject
 
 public:
     /**
-     * @brief Create a QAbstractSeries from a list of points
+     * @brief Create a QAbstractSeries from a list of raw samples
+     *  Samples are normalized from 0-255 to 0-1 while the series is created
      *
      * @param series
-     * @param points
+     * @param samples
      * @param initPos
      * @param finalPos
      * @param minPoint
      * @param maxPoint
      * @param multiplier
      */
-    Q_INVOKABLE void update(QtCharts::QAbstractSeries * series, const QVector<double>& points,
+    Q_INVOKABLE void update(QtCharts::QAbstractSeries * series, const QByteArray& samples,
                             const float initPos, const float finalPos,
                             const float minPoint, const float maxPoint,
                             const float multiplier = 1
@@ -0,0 +1,367 @@
+#include <cmath>
+
+#include "columnkernel.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define COLUMNKERNEL_SSE2
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define COLUMNKERNEL_NEON
+#include <arm_neon.h>
+#endif
+
+namespace
+{
+/**
+ * @brief Return the first and last samples covered by a row
+ *
+ */
+inline void rowRange(float position, float samplesPerRow, int srcLength, int& first, int& last)
+{
+    const float halfRow = samplesPerRow*0.5f;
+    first = static_cast<int>(std::floor(position - halfRow));
+    last = static_cast<int>(std::ceil(position + halfRow)) - 1;
+    first = first < 0 ? 0 : (first >= srcLength ? srcLength - 1 : first);
+    last = last < first ? first : (last >= srcLength ? srcLength - 1 : last);
+}
+
+inline uint8_t maxScalar(const uint8_t* src, int first, int last)
+{
+    uint8_t value = src[first];
+    for(int i = first + 1; i <= last; i++) {
+        value = src[i] > value ? src[i] : value;
+    }
+    return value;
+}
+
+inline int clampIndex(float position, int srcLength)
+{
+    position = position < 0 ? 0 : position;
+    position = position > srcLength - 1 ? srcLength - 1 : position;
+    return static_cast<int>(position);
+}
+
+/**
+ * @brief Scalar resample of rows between firstRow and lastRow (not included)
+ *
+ */
+void resampleRows(const uint8_t* src, int srcLength, float firstSample, float samplesPerRow,
+                  uint8_t* dst, int firstRow, int lastRow, ColumnKernel::Mode mode)
+{
+    switch(mode) {
+    case ColumnKernel::Nearest:
+        for(int row = firstRow; row < lastRow; row++) {
+            dst[row] = src[clampIndex(firstSample + static_cast<float>(row)*samplesPerRow, srcLength)];
+        }
+        break;
+
+    case ColumnKernel::Linear:
+        for(int row = firstRow; row < lastRow; row++) {
+            // Sample centers are in i + 0.5
+            float position = firstSample + static_cast<float>(row)*samplesPerRow - 0.5f;
+            position = position < 0 ? 0 : (position > srcLength - 1 ? srcLength - 1 : position);
+            const int index = static_cast<int>(position);
+            const int next = index + 1 < srcLength ? index + 1 : index;
+            const float fraction = position - index;
+            const float a = src[index];
+            const float b = src[next];
+            dst[row] = static_cast<uint8_t>(a + (b - a)*fraction + 0.5f);
+        }
+        break;
+
+    case ColumnKernel::Max:
+        for(int row = firstRow; row < lastRow; row++) {
+            int firstRowSample;
+            int lastRowSample;
+            const float position = firstSample + static_cast<float>(row)*samplesPerRow;
+            rowRange(position, samplesPerRow, srcLength, firstRowSample, lastRowSample);
+            dst[row] = maxScalar(src, firstRowSample, lastRowSample);
+        }
+        break;
+    }
+}
+
+/**
+ * @brief Scalar smooth of samples between first and last (not included)
+ *
+ */
+void smoothRows(const uint8_t* src, int first, int last, float alpha, float* state, uint8_t* dst)
+{
+    for(int i = first; i < last; i++) {
+        state[i] = state[i] + alpha*(src[i] - state[i]);
+        dst[i] = static_cast<uint8_t>(static_cast<int>(state[i] + 0.5f));
+    }
+}
+
+void smoothRows(const uint8_t* src, int first, int last, int16_t alpha, int16_t* state, uint8_t* dst)
+{
+    for(int i = first; i < last; i++) {
+        const int diff = (src[i] << 6) - state[i];
+        // Same as the 16 bits high multiplication used by the SIMD versions
+        state[i] = static_cast<int16_t>(state[i] + ((2*diff*alpha) >> 16));
+        dst[i] = static_cast<uint8_t>((state[i] + 32) >> 6);
+    }
+}
+
+#if defined(COLUMNKERNEL_SSE2) || defined(COLUMNKERNEL_NEON)
+#if defined(COLUMNKERNEL_SSE2)
+typedef __m128 Float4;
+typedef __m128i Int4;
+inline Float4 set1(float value) { return _mm_set1_ps(value); }
+inline Float4 set4(float a, float b, float c, float d) { return _mm_set_ps(d, c, b, a); }
+inline Float4 add(Float4 a, Float4 b) { return _mm_add_ps(a, b); }
+inline Float4 sub(Float4 a, Float4 b) { return _mm_sub_ps(a, b); }
+inline Float4 mul(Float4 a, Float4 b) { return _mm_mul_ps(a, b); }
+inline Float4 clamp(Float4 a, Float4 min, Float4 max) { return _mm_min_ps(_mm_max_ps(a, min), max); }
+inline Int4 truncate(Float4 a) { return _mm_cvttps_epi32(a); }
+inline Float4 toFloat(Int4 a) { return _mm_cvtepi32_ps(a); }
+inline void store(int32_t* dst, Int4 a) { _mm_storeu_si128(reinterpret_cast<__m128i*>(dst), a); }
+inline Float4 load(const float* src) { return _mm_loadu_ps(src); }
+inline void store(float* dst, Float4 a) { _mm_storeu_ps(dst, a); }
+
+/**
+ * @brief Fixed-point smooth of 8 samples
+ *
+ */
+inline void smoothFixed8(const uint8_t* src, int16_t alpha, int16_t* state, uint8_t* dst)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i samples = _mm_slli_epi16(
+                                _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(src)), zero), 6);
+    __m128i value = _mm_loadu_si128(reinterpret_cast<const __m128i*>(state));
+    const __m128i diff = _mm_sub_epi16(samples, value);
+    value = _mm_add_epi16(value, _mm_mulhi_epi16(_mm_add_epi16(diff, diff), _mm_set1_epi16(alpha)));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(state), value);
+    const __m128i output = _mm_srli_epi16(_mm_add_epi16(value, _mm_set1_epi16(32)), 6);
+    _mm_storel_epi64(reinterpret_cast<__m128i*>(dst), _mm_packus_epi16(output, zero));
+}
+
+inline uint8_t maxVector(const uint8_t* src, int first, int last)
+{
+    __m128i value = _mm_set1_epi8(static_cast<char>(src[first]));
+    int i = first;
+    for(; i + 16 <= last + 1; i += 16) {
+        value = _mm_max_epu8(value, _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i)));
+    }
+    value = _mm_max_epu8(value, _mm_srli_si128(value, 8));
+    value = _mm_max_epu8(value, _mm_srli_si128(value, 4));
+    value = _mm_max_epu8(value, _mm_srli_si128(value, 2));
+    value = _mm_max_epu8(value, _mm_srli_si128(value, 1));
+    const uint8_t vectorValue = static_cast<uint8_t>(_mm_cvtsi128_si32(value) & 0xff);
+    const uint8_t tailValue = i <= last ? maxScalar(src, i, last) : 0;
+    return vectorValue > tailValue ? vectorValue : tailValue;
+}
+#else
+typedef float32x4_t Float4;
+typedef int32x4_t Int4;
+inline Float4 set1(float value) { return vdupq_n_f32(value); }
+inline Float4 set4(float a, float b, float c, float d)
+{
+    const float values[4] = {a, b, c, d};
+    return vld1q_f32(values);
+}
+inline Float4 add(Float4 a, Float4 b) { return vaddq_f32(a, b); }
+inline Float4 sub(Float4 a, Float4 b) { return vsubq_f32(a, b); }
+inline Float4 mul(Float4 a, Float4 b) { return vmulq_f32(a, b); }
+inline Float4 clamp(Float4 a, Float4 min, Float4 max) { return vminq_f32(vmaxq_f32(a, min), max); }
+inline Int4 truncate(Float4 a) { return vcvtq_s32_f32(a); }
+inline Float4 toFloat(Int4 a) { return vcvtq_f32_s32(a); }
+inline void store(int32_t* dst, Int4 a) { vst1q_s32(dst, a); }
+inline Float4 load(const float* src) { return vld1q_f32(src); }
+inline void store(float* dst, Float4 a) { vst1q_f32(dst, a); }
+
+/**
+ * @brief Fixed-point smooth of 8 samples
+ *
+ */
+inline void smoothFixed8(const uint8_t* src, int16_t alpha, int16_t* state, uint8_t* dst)
+{
+    const int16x8_t samples = vreinterpretq_s16_u16(vshlq_n_u16(vmovl_u8(vld1_u8(src)), 6));
+    int16x8_t value = vld1q_s16(state);
+    // vqdmulhq does (2*a*b) >> 16, diff*2 never saturates since diff is inside 15 bits
+    value = vaddq_s16(value, vqdmulhq_s16(vsubq_s16(samples, value), vdupq_n_s16(alpha)));
+    vst1q_s16(state, value);
+    vst1_u8(dst, vqrshrun_n_s16(value, 6));
+}
+
+inline uint8_t maxVector(const uint8_t* src, int first, int last)
+{
+    uint8x16_t value = vdupq_n_u8(src[first]);
+    int i = first;
+    for(; i + 16 <= last + 1; i += 16) {
+        value = vmaxq_u8(value, vld1q_u8(src + i));
+    }
+    uint8x8_t half = vmax_u8(vget_low_u8(value), vget_high_u8(value));
+    half = vpmax_u8(half, half);
+    half = vpmax_u8(half, half);
+    half = vpmax_u8(half, half);
+    const uint8_t vectorValue = vget_lane_u8(half, 0);
+    const uint8_t tailValue = i <= last ? maxScalar(src, i, last) : 0;
+    return vectorValue > tailValue ? vectorValue : tailValue;
+}
+#endif
+
+void resampleVector(const uint8_t* src, int srcLength, float firstSample, float samplesPerRow,
+                    uint8_t* dst, int rows, ColumnKernel::Mode mode)
+{
+    const Float4 step = set1(samplesPerRow);
+    const Float4 first = set1(firstSample);
+    const Float4 offsets = set4(0, 1, 2, 3);
+    const Float4 half = set1(0.5f);
+    const Float4 zero = set1(0);
+    const Float4 lastIndex = set1(srcLength - 1);
+    int32_t indexes[4];
+
+    int row = 0;
+    switch(mode) {
+    case ColumnKernel::Nearest:
+        for(; row + 4 <= rows; row += 4) {
+            const Float4 position = add(first, mul(add(set1(row), offsets), step));
+            store(indexes, truncate(clamp(position, zero, lastIndex)));
+            dst[row] = src[indexes[0]];
+            dst[row + 1] = src[indexes[1]];
+            dst[row + 2] = src[indexes[2]];
+            dst[row + 3] = src[indexes[3]];
+        }
+        break;
+
+    case ColumnKernel::Linear:
+        for(; row + 4 <= rows; row += 4) {
+            // Sample centers are in i + 0.5
+            const Float4 position = sub(add(first, mul(add(set1(row), offsets), step)), half);
+            const Float4 clamped = clamp(position, zero, lastIndex);
+            const Int4 index = truncate(clamped);
+            const Float4 fraction = sub(clamped, toFloat(index));
+            store(indexes, index);
+            const int next0 = indexes[0] + 1 < srcLength ? indexes[0] + 1 : indexes[0];
+            const int next1 = indexes[1] + 1 < srcLength ? indexes[1] + 1 : indexes[1];
+            const int next2 = indexes[2] + 1 < srcLength ? indexes[2] + 1 : indexes[2];
+            const int next3 = indexes[3] + 1 < srcLength ? indexes[3] + 1 : indexes[3];
+            const Float4 a = set4(src[indexes[0]], src[indexes[1]], src[indexes[2]], src[indexes[3]]);
+            const Float4 b = set4(src[next0], src[next1], src[next2], src[next3]);
+            store(indexes, truncate(add(add(a, mul(sub(b, a), fraction)), half)));
+            dst[row] = static_cast<uint8_t>(indexes[0]);
+            dst[row + 1] = static_cast<uint8_t>(indexes[1]);
+            dst[row + 2] = static_cast<uint8_t>(indexes[2]);
+            dst[row + 3] = static_cast<uint8_t>(indexes[3]);
+        }
+        break;
+
+    case ColumnKernel::Max:
+        for(; row < rows; row++) {
+            int firstRowSample;
+            int lastRowSample;
+            const float position = firstSample + static_cast<float>(row)*samplesPerRow;
+            rowRange(position, samplesPerRow, srcLength, firstRowSample, lastRowSample);
+            dst[row] = maxVector(src, firstRowSample, lastRowSample);
+        }
+        break;
+    }
+
+    // Do the tail with the scalar version
+    resampleRows(src, srcLength, firstSample, samplesPerRow, dst, row, rows, mode);
+}
+
+void smoothVector(const uint8_t* src, int length, float alpha, float* state, uint8_t* dst)
+{
+    const Float4 weight = set1(alpha);
+    const Float4 half = set1(0.5f);
+    int32_t values[4];
+
+    int i = 0;
+    for(; i + 4 <= length; i += 4) {
+        const Float4 samples = set4(src[i], src[i + 1], src[i + 2], src[i + 3]);
+        Float4 value = load(state + i);
+        value = add(value, mul(weight, sub(samples, value)));
+        store(state + i, value);
+        store(values, truncate(add(value, half)));
+        dst[i] = static_cast<uint8_t>(values[0]);
+        dst[i + 1] = static_cast<uint8_t>(values[1]);
+        dst[i + 2] = static_cast<uint8_t>(values[2]);
+        dst[i + 3] = static_cast<uint8_t>(values[3]);
+    }
+
+    smoothRows(src, i, length, alpha, state, dst);
+}
+
+void smoothVector(const uint8_t* src, int length, int16_t alpha, int16_t* state, uint8_t* dst)
+{
+    int i = 0;
+    for(; i + 8 <= length; i += 8) {
+        smoothFixed8(src + i, alpha, state + i, dst + i);
+    }
+
+    smoothRows(src, i, length, alpha, state, dst);
+}
+#endif
+}
+
+void ColumnKernel::resampleScalar(const uint8_t* src, int srcLength, float firstSample, float samplesPerRow,
+                                  uint8_t* dst, int rows, Mode mode)
+{
+    if(srcLength <= 0 || rows <= 0) {
+        return;
+    }
+
+    resampleRows(src, srcLength, firstSample, samplesPerRow, dst, 0, rows, mode);
+}
+
+void ColumnKernel::resample(const uint8_t* src, int srcLength, float firstSample, float samplesPerRow,
+                            uint8_t* dst, int rows, Mode mode)
+{
+    if(srcLength <= 0 || rows <= 0) {
+        return;
+    }
+
+#if defined(COLUMNKERNEL_SSE2) || defined(COLUMNKERNEL_NEON)
+    resampleVector(src, srcLength, firstSample, samplesPerRow, dst, rows, mode);
+#else
+    resampleScalar(src, srcLength, firstSample, samplesPerRow, dst, rows, mode);
+#endif
+}
+
+void ColumnKernel::colorize(const uint8_t* values, int length, const uint32_t* colorTable, uint32_t* dst, int stride)
+{
+    int i = 0;
+    for(; i + 4 <= length; i += 4) {
+        const uint32_t color0 = colorTable[values[i]];
+        const uint32_t color1 = colorTable[values[i + 1]];
+        const uint32_t color2 = colorTable[values[i + 2]];
+        const uint32_t color3 = colorTable[values[i + 3]];
+        dst[i*stride] = color0;
+        dst[(i + 1)*stride] = color1;
+        dst[(i + 2)*stride] = color2;
+        dst[(i + 3)*stride] = color3;
+    }
+    for(; i < length; i++) {
+        dst[i*stride] = colorTable[values[i]];
+    }
+}
+
+void ColumnKernel::smoothScalar(const uint8_t* src, int length, float alpha, float* state, uint8_t* dst)
+{
+    smoothRows(src, 0, length, alpha, state, dst);
+}
+
+void ColumnKernel::smooth(const uint8_t* src, int length, float alpha, float* state, uint8_t* dst)
+{
+#if defined(COLUMNKERNEL_SSE2) || defined(COLUMNKERNEL_NEON)
+    smoothVector(src, length, alpha, state, dst);
+#else
+    smoothScalar(src, length, alpha, state, dst);
+#endif
+}
+
+void ColumnKernel::smoothScalar(const uint8_t* src, int length, int16_t alpha, int16_t* state, uint8_t* dst)
+{
+    smoothRows(src, 0, length, alpha, state, dst);
+}
+
+void ColumnKernel::smooth(const uint8_t* src, int length, int16_t alpha, int16_t* state, uint8_t* dst)
+{
+#if defined(COLUMNKERNEL_SSE2) || defined(COLUMNKERNEL_NEON)
+    smoothVector(src, length, alpha, state, dst);
+#else
+    smoothScalar(src, length, alpha, state, dst);
+#endif
+}
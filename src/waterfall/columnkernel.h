@@ -0,0 +1,111 @@
+#pragma once
+
+#include <cstdint>
+
+/**
+ * @brief Resample and colorize kernels for waterfall columns
+ *  The SIMD versions are used with SSE2 (x86) and NEON (ARM), otherwise the scalar version is used.
+ *
+ *  Row positions are defined in sample units, the center of the row r is:
+ *      position = firstSample + r*samplesPerRow
+ *  Where the center of the sample i is i + 0.5.
+ *
+ */
+namespace ColumnKernel
+{
+/**
+ * @brief Resample modes
+ *
+ */
+enum Mode {
+    Nearest,    // Sample under the row center
+    Linear,     // Linear interpolation between the two closest samples
+    Max,        // Max value of all samples covered by the row, this keeps thin targets when downsampling
+};
+
+/**
+ * @brief Resample a column
+ *
+ * @param src column samples
+ * @param srcLength number of samples
+ * @param firstSample position of the first row center
+ * @param samplesPerRow distance between two rows in samples
+ * @param dst output with rows values
+ * @param rows number of rows
+ * @param mode
+ */
+void resample(const uint8_t* src, int srcLength, float firstSample, float samplesPerRow,
+              uint8_t* dst, int rows, Mode mode);
+
+/**
+ * @brief Scalar version of resample, this is the fallback and reference implementation
+ *
+ * @param src column samples
+ * @param srcLength number of samples
+ * @param firstSample position of the first row center
+ * @param samplesPerRow distance between two rows in samples
+ * @param dst output with rows values
+ * @param rows number of rows
+ * @param mode
+ */
+void resampleScalar(const uint8_t* src, int srcLength, float firstSample, float samplesPerRow,
+                    uint8_t* dst, int rows, Mode mode);
+
+/**
+ * @brief Colorize values using a 256 entry color table
+ *
+ * @param values
+ * @param length number of values
+ * @param colorTable
+ * @param dst first output pixel
+ * @param stride distance between two output pixels, in pixels
+ */
+void colorize(const uint8_t* values, int length, const uint32_t* colorTable, uint32_t* dst, int stride);
+
+/**
+ * @brief Exponential smoothing with float state
+ *      state = state + alpha*(src - state)
+ *
+ * @param src new column samples
+ * @param length number of samples
+ * @param alpha weight of the new samples, between 0 and 1
+ * @param state previous smoothed column, updated in place
+ * @param dst rounded state
+ */
+void smooth(const uint8_t* src, int length, float alpha, float* state, uint8_t* dst);
+
+/**
+ * @brief Scalar version of the float smooth, this is the fallback and reference implementation
+ *
+ * @param src new column samples
+ * @param length number of samples
+ * @param alpha weight of the new samples, between 0 and 1
+ * @param state previous smoothed column, updated in place
+ * @param dst rounded state
+ */
+void smoothScalar(const uint8_t* src, int length, float alpha, float* state, uint8_t* dst);
+
+/**
+ * @brief Exponential smoothing with fixed-point state
+ *  The state uses 6 fractional bits (value*64) and alpha uses 15 fractional bits (alpha*32768),
+ *  this keeps all intermediate values inside 16 bits.
+ *
+ * @param src new column samples
+ * @param length number of samples
+ * @param alpha weight of the new samples in Q15
+ * @param state previous smoothed column in Q8.6, updated in place
+ * @param dst rounded state
+ */
+void smooth(const uint8_t* src, int length, int16_t alpha, int16_t* state, uint8_t* dst);
+
+/**
+ * @brief Scalar version of the fixed-point smooth, this is the fallback and reference implementation
+ *
+ * @param src new column samples
+ * @param length number of samples
+ * @param alpha weight of the new samples in Q15
+ * @param state previous smoothed column in Q8.6, updated in place
+ * @param dst rounded state
+ */
+void smoothScalar(const uint8_t* src, int length, int16_t alpha, int16_t* state, uint8_t* dst);
+}
@@ -0,0 +1,60 @@
+#include <cstring>
+
+#include <QtGlobal>
+
+#include "columnkernel.h"
+#include "columnsmoother.h"
+
+ColumnSmoother::ColumnSmoother(float alpha, Storage storage)
+    : _storage(storage)
+    , _length(0)
+{
+    setAlpha(alpha);
+}
+
+void ColumnSmoother::setAlpha(float alpha)
+{
+    _alpha = qBound(0.0f, alpha, 1.0f);
+    _fixedAlpha = static_cast<int16_t>(qMin(qRound(_alpha*32768), 32767));
+}
+
+void ColumnSmoother::setStorage(Storage storage)
+{
+    if(_storage == storage) {
+        return;
+    }
+
+    _storage = storage;
+    reset();
+}
+
+void ColumnSmoother::apply(const uint8_t* samples, int length, uint8_t* output)
+{
+    if(!samples || !output || length <= 0) {
+        return;
+    }
+
+    // Start again with the new column if there is no state or the profile length changed
+    if(length != _length) {
+        _length = length;
+        if(_storage == Float) {
+            _floatState.resize(length);
+            for(int i = 0; i < length; i++) {
+                _floatState[i] = samples[i];
+            }
+        } else {
+            _fixedState.resize(length);
+            for(int i = 0; i < length; i++) {
+                _fixedState[i] = static_cast<int16_t>(samples[i] << 6);
+            }
+        }
+        memcpy(output, samples, length);
+        return;
+    }
+
+    if(_storage == Float) {
+        ColumnKernel::smooth(samples, length, _alpha, _floatState.data(), output);
+    } else {
+        ColumnKernel::smooth(samples, length, _fixedAlpha, _fixedState.data(), output);
+    }
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <QVector>
+
+/**
+ * @brief Exponential smoothing between consecutive waterfall columns
+ *      state = state + alpha*(column - state)
+ *  The state can be stored as float or as 16 bits fixed-point, the last one halves the memory used by the filter.
+ *  When the column length changes the state is restarted with the new column.
+ *
+ */
+class ColumnSmoother
+{
+public:
+    /**
+     * @brief State storage type
+     *
+     */
+    enum Storage {
+        Float,
+        FixedPoint,
+    };
+
+    /**
+     * @brief Construct a new Column Smoother object
+     *
+     * @param alpha weight of the new column, between 0 and 1
+     * @param storage
+     */
+    ColumnSmoother(float alpha = 0.2f, Storage storage = FixedPoint);
+
+    /**
+     * @brief Filter a new column
+     *
+     * @param samples
+     * @param length
+     * @param output filtered column with length samples
+     */
+    void apply(const uint8_t* samples, int length, uint8_t* output);
+
+    /**
+     * @brief Restart the filter, the next column will be used as the initial state
+     *
+     */
+    void reset() { _length = 0; };
+
+    /**
+     * @brief Return the weight of the new column
+     *
+     * @return float
+     */
+    float alpha() const { return _alpha; };
+
+    /**
+     * @brief Set the weight of the new column
+     *
+     * @param alpha between 0 and 1
+     */
+    void setAlpha(float alpha);
+
+    /**
+     * @brief Return the state storage type
+     *
+     * @return Storage
+     */
+    Storage storage() const { return _storage; };
+
+    /**
+     * @brief Set the state storage type, this restarts the filter
+     *
+     * @param storage
+     */
+    void setStorage(Storage storage);
+
+private:
+    float _alpha;
+    // Alpha in Q15 for the fixed-point filter
+    int16_t _fixedAlpha;
+    Storage _storage;
+    // Length of the current state, 0 if there is no state
+    int _length;
+    QVector<float> _floatState;
+    // Q8.6 state
+    QVector<int16_t> _fixedState;
+};
@@ -1,19 +1,26 @@
 #pragma once
 
+#include <algorithm>
+#include <functional>
+
 #include <QVector>
 
 /**
  * @brief Ring vector class template
+ *  The storage has a power of two size, so positions are found with a mask.
+ *  Memory is only allocated by fill, append and appendBulk never allocate.
  *
  * @tparam T
  */
 template <typename T>
-class RingVector: public QVector<T>
+class RingVector
 {
 public:
     RingVector()
         : _accessType(FIFO)
-        , _appendIndex(-1) {}
+        , _end(0)
+        , _length(0)
+        , _mask(0) {}
 
     /**
      * @brief Ring buffer type
@@ -24,6 +31,38 @@ public:
         LIFO    // 0 will be the oldest data to append
     };
 
+    /**
+     * @brief Contiguous part of the ring
+     *
+     */
+    struct Span {
+        const T* data;
+        int length;
+    };
+
+    /**
+     * @brief Iterator from the oldest to the newest value
+     *
+     */
+    class const_iterator
+    {
+    public:
+        const_iterator(const RingVector* ring, uint position)
+            : _ring(ring)
+            , _position(position) {}
+
+        const T& operator*() const { return _ring->_data[_position & _ring->_mask]; }
+        const T* operator->() const { return &_ring->_data[_position & _ring->_mask]; }
+        const_iterator& operator++() { _position++; return *this; }
+        const_iterator operator++(int) { const_iterator it = *this; _position++; return it; }
+        bool operator==(const const_iterator& other) const { return _position == other._position; }
+        bool operator!=(const const_iterator& other) const { return _position != other._position; }
+
+    private:
+        const RingVector* _ring;
+        uint _position;
+    };
+
     /**
      * @brief Vector access type
      */
@@ -32,33 +71,216 @@ public:
         _accessType = accessType;
     }
 
+    /**
+     * @brief Set the ring length and fill it with value
+     *  The storage is rounded up to the next power of two
+     */
+    void fill(const T& value, int length)
+    {
+        _length = qMax(length, 0);
+        uint capacity = 1;
+        while(capacity < static_cast<uint>(_length)) {
+            capacity <<= 1;
+        }
+        _data.fill(value, capacity);
+        _mask = capacity - 1;
+        _end = 0;
+    }
+
     /**
      * @brief Access vector
      */
     T& operator[](int id)
     {
-        int index;
-        if(_accessType == FIFO) {
-            index = _appendIndex - id;
-            while(index < 0) {
-                index += QVector<T>::length();
-            }
-        } else {
-            index = id;
-        }
-        return QVector<T>::operator[](index%QVector<T>::length());
+        return _data[position(id) & _mask];
+    }
+
+    const T& operator[](int id) const
+    {
+        return _data[position(id) & _mask];
     }
 
     /**
      * @brief Append value in vector, remove oldest
      */
-    void append(const T &value)
+    void append(const T& value)
     {
-        _appendIndex++;
-        QVector<T>::operator[](_appendIndex%QVector<T>::length()) = value;
+        if(!_length) {
+            return;
+        }
+        _data[_end & _mask] = value;
+        _end++;
     }
 
+    /**
+     * @brief Append values in vector, from the oldest to the newest, removing the oldest ones
+     */
+    void appendBulk(const T* values, int count)
+    {
+        if(!_length || count <= 0) {
+            return;
+        }
+
+        // Only the last length values will be available
+        if(count > _length) {
+            values += count - _length;
+            _end += count - _length;
+            count = _length;
+        }
+
+        const int firstPart = qMin(count, static_cast<int>(_mask + 1 - (_end & _mask)));
+        std::copy(values, values + firstPart, _data.data() + (_end & _mask));
+        std::copy(values + firstPart, values + count, _data.data());
+        _end += count;
+    }
+
+    /**
+     * @brief Return the oldest contiguous part of the ring
+     *  The values from the oldest to the newest are firstSpan followed by secondSpan
+     */
+    Span firstSpan() const
+    {
+        const uint start = (_end - _length) & _mask;
+        return {_data.constData() + start, qMin(_length, static_cast<int>(_mask + 1 - start))};
+    }
+
+    /**
+     * @brief Return the newest contiguous part of the ring, it can be empty
+     */
+    Span secondSpan() const
+    {
+        return {_data.constData(), _length - firstSpan().length};
+    }
+
+    const_iterator begin() const { return const_iterator(this, _end - _length); }
+    const_iterator end() const { return const_iterator(this, _end); }
+
+    int length() const { return _length; }
+    int size() const { return _length; }
+    bool isEmpty() const { return !_length; }
+
 private:
+    /**
+     * @brief Return the unmasked position of an index
+     */
+    uint position(int id) const
+    {
+        return _accessType == FIFO ? _end - 1 - id : _end - _length + id;
+    }
+
     ACCESS_TYPE _accessType;
-    uint _appendIndex;
-};
\ No newline at end of file
+    QVector<T> _data;
+    // Unmasked position after the newest value
+    uint _end;
+    int _length;
+    uint _mask;
+};
+
+/**
+ * @brief Sliding window extreme class template
+ *  Keeps the min (std::less) or max (std::greater) of the last window values appended, with amortised O(1) cost
+ *  for each append. It should be fed with the same values of a RingVector to give windowed statistics of it.
+ *
+ *  This is a monotonic deque: old values that can't be the extreme anymore are removed when a new value arrives,
+ *  the deque is stored in a ring with window entries, so there is no allocation after setWindow.
+ *
+ * @tparam T
+ * @tparam Compare returns true if the first argument should be kept instead of the second
+ */
+template <typename T, typename Compare = std::less<T>>
+class RingWindowExtreme
+{
+public:
+    RingWindowExtreme(int window = 1)
+        : _count(0)
+        , _head(0)
+        , _size(0)
+    {
+        setWindow(window);
+    }
+
+    /**
+     * @brief Set the number of values in the window, this removes all values
+     *
+     * @param window
+     */
+    void setWindow(int window)
+    {
+        _entries.resize(qMax(window, 1));
+        clear();
+    }
+
+    /**
+     * @brief Return the number of values in the window
+     *
+     * @return int
+     */
+    int window() const
+    {
+        return _entries.length();
+    }
+
+    /**
+     * @brief Remove all values
+     */
+    void clear()
+    {
+        _count = 0;
+        _head = 0;
+        _size = 0;
+    }
+
+    /**
+     * @brief Append a new value, the oldest value of the window is removed
+     */
+    void append(const T& value)
+    {
+        const int window = _entries.length();
+
+        // Remove the values that will never be the extreme again
+        while(_size > 0 && !_compare(_entries[(_head + _size - 1)%window].value, value)) {
+            _size--;
+        }
+
+        // Remove the values that are outside of the window
+        if(_size > 0 && _entries[_head].index + window <= _count) {
+            _head = (_head + 1)%window;
+            _size--;
+        }
+
+        _entries[(_head + _size)%window] = {_count, value};
+        _size++;
+        _count++;
+    }
+
+    /**
+     * @brief Return true if there is no value in the window
+     */
+    bool isEmpty() const
+    {
+        return _size == 0;
+    }
+
+    /**
+     * @brief Return the extreme value of the window, the window should not be empty
+     */
+    const T& value() const
+    {
+        Q_ASSERT(!isEmpty());
+        return _entries[_head].value;
+    }
+
+private:
+    struct Entry {
+        quint64 index;
+        T value;
+    };
+
+    Compare _compare;
+    // Number of values appended
+    quint64 _count;
+    // Deque with values and indexes in ascending order
+    QVector<Entry> _entries;
+    int _head;
+    int _size;
+};
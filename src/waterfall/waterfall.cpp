@@ -1,10 +1,12 @@
+#include "columnkernel.h"
 #include "filemanager.h"
 #include "waterfall.h"
 
 #include <limits>
 
 #include <QtConcurrent>
-#include <QPainter>
+#include <QQuickWindow>
+#include <QSGImageNode>
 #include <QtMath>
 #include <QVector>
 
@@ -13,41 +15,136 @@ PING_LOGGING_CATEGORY(waterfall, "ping.waterfall")
 // Number of samples to display
 uint16_t Waterfall::displayWidth = 500;
 
+// Used to populate the depth and confidence ring without valid samples
+static const float invalidDepth = std::numeric_limits<float>::max();
+
+// Max number of rows in the rendered image
+static const int maxRenderHeight = 2500;
+
+// Number of columns in each texture tile
+static const int tileWidth = 50;
+
+/**
+ * @brief Waterfall scene graph node
+ *  The rendered image is split in tiles of tileWidth columns, each tile has its own texture.
+ *  The tile that contains the oldest column is split between the left and right side of the waterfall,
+ *  the right part is done by wrapNode.
+ */
+class WaterfallNode : public QSGNode
+{
+public:
+    ~WaterfallNode() { qDeleteAll(textures); }
+
+    QVector<QSGImageNode*> tileNodes;
+    QVector<QSGTexture*> textures;
+    QSGImageNode* wrapNode = nullptr;
+};
+
 Waterfall::Waterfall(QQuickItem *parent):
-    QQuickPaintedItem(parent),
-    _image(2048, 2500, QImage::Format_RGBA8888),
-    _painter(nullptr),
-    _maxDepthToDrawInPixels(0),
-    _minDepthToDrawInPixels(0),
+    QQuickItem(parent),
+    _history(12288, 200),
+    _historyLevel(0),
+    _historyOffset(0),
+    _image(displayWidth, 1, QImage::Format_ARGB32_Premultiplied),
+    _maxDepthToDraw(0),
+    _minDepthToDraw(0),
     _mouseDepth(0),
+    _mouseValue(-1),
     _containsMouse(false),
     _smooth(true),
-    _updateTimer(new QTimer(this)),
-    currentDrawIndex(displayWidth)
+    _pendingColumns(0),
+    _renderDirty(true),
+    _renderedMaxDepth(0),
+    _renderedMinDepth(0),
+    _dirtyTiles((displayWidth + tileWidth - 1)/tileWidth, true)
 {
+    setFlag(ItemHasContents);
     // This is the max depth that ping returns
     setWaterfallMaxDepth(70);
-    _DCRing.fill({static_cast<float>(_image.height()), 0, 0, 0}, displayWidth);
+    _DCRing.fill({invalidDepth, 0, 0, 0}, displayWidth);
+    _minDepthWindow.setWindow(displayWidth);
+    _maxDepthWindow.setWindow(displayWidth);
     setAntialiasing(_smooth);
     setAcceptedMouseButtons(Qt::AllButtons);
     setAcceptHoverEvents(true);
-    _image.fill(QColor(Qt::transparent));
+    _image.fill(Qt::transparent);
     setGradients();
     setTheme("Thermal 5");
-
-    connect(_updateTimer, &QTimer::timeout, this, [&] {update();});
-    _updateTimer->setSingleShot(true);
-    _updateTimer->start(50);
+    update();
 }
 
 void Waterfall::clear()
 {
     qCDebug(waterfall) << "Cleaning waterfall and restarting internal variables";
-    _maxDepthToDrawInPixels = 0;
-    _minDepthToDrawInPixels = 0;
     _mouseDepth = 0;
-    _DCRing.fill({static_cast<float>(_image.height()), 0, 0, 0}, displayWidth);
-    _image.fill(Qt::transparent);
+    _DCRing.fill({invalidDepth, 0, 0, 0}, displayWidth);
+    _minDepthWindow.clear();
+    _maxDepthWindow.clear();
+    _history.clear();
+    _pendingProfiles.clear();
+    _historyOffset = 0;
+    _pendingColumns = 0;
+    _renderDirty = true;
+    update();
+    emit historyOffsetChanged();
+    emit historySizeChanged();
+}
+
+void Waterfall::setHistoryLevel(int level)
+{
+    level = qBound(0, level, WaterfallPyramid::levels - 1);
+    if(level == _historyLevel) {
+        return;
+    }
+
+    // Keep the newest displayed profile in the new level
+    const int profileAge = _historyOffset*WaterfallPyramid::decimation(_historyLevel);
+    _historyLevel = level;
+    _historyOffset = profileAge/WaterfallPyramid::decimation(_historyLevel);
+    _renderDirty = true;
+    updateDepthWindow();
+    update();
+    emit historyLevelChanged();
+    emit historyOffsetChanged();
+    emit historySizeChanged();
+}
+
+void Waterfall::setHistoryOffset(int offset)
+{
+    offset = qBound(0, offset, qMax(0, historySize() - 1));
+    if(offset == _historyOffset) {
+        return;
+    }
+
+    _historyOffset = offset;
+    _renderDirty = true;
+    updateDepthWindow();
+    update();
+    emit historyOffsetChanged();
+}
+
+void Waterfall::updateDepthWindow()
+{
+    if(isLive()) {
+        _minDepthToDraw = _minDepthWindow.isEmpty() ? std::numeric_limits<float>::max() : _minDepthWindow.value();
+        _maxDepthToDraw = _maxDepthWindow.isEmpty() ? 0 : _maxDepthWindow.value();
+    } else {
+        // Use the depth range of the visible columns of the displayed level
+        const WaterfallHistory& level = _history.level(_historyLevel);
+        const int lastAge = qMin(level.size(), _historyOffset + displayWidth);
+        float minDepth = std::numeric_limits<float>::max();
+        float maxDepth = 0;
+        for(int age = _historyOffset; age < lastAge; age++) {
+            const WaterfallHistory::ColumnInfo& info = level.info(age);
+            minDepth = qMin(minDepth, info.initialDepth);
+            maxDepth = qMax(maxDepth, info.initialDepth + info.length);
+        }
+        _minDepthToDraw = minDepth;
+        _maxDepthToDraw = maxDepth;
+    }
+
+    emit minDepthToDrawChanged();
+    emit maxDepthToDrawChanged();
 }
 
 void Waterfall::setGradients()
@@ -124,7 +221,6 @@ void Waterfall::loadUserGradients()
 void Waterfall::setWaterfallMaxDepth(float maxDepth)
 {
     _waterfallDepth = maxDepth;
-    _minPixelsPerMeter = _image.height()/_waterfallDepth;
 }
 
 void Waterfall::setTheme(const QString& theme)
@@ -136,241 +232,286 @@ void Waterfall::setTheme(const QString& theme)
             break;
         }
     }
+    // The entire history is colorized again with the new theme
+    _renderDirty = true;
+    update();
 }
 
-void Waterfall::paint(QPainter *painter)
+void Waterfall::setSmoothFactor(float factor)
 {
-    static QPixmap pix;
-    if(painter != _painter) {
-        _painter = painter;
+    if(qFuzzyCompare(factor, _smoother.alpha())) {
+        return;
     }
 
-    static uint16_t first;
+    _smoother.setAlpha(factor);
+    // The filter is applied again over the visible history
+    _renderDirty = true;
+    update();
+    emit smoothFactorChanged();
+}
 
-    if (currentDrawIndex < displayWidth) {
-        first = 0;
-    } else {
-        first = currentDrawIndex - displayWidth;
+QSGNode* Waterfall::updatePaintNode(QSGNode* oldNode, UpdatePaintNodeData* updatePaintNodeData)
+{
+    Q_UNUSED(updatePaintNodeData)
+
+    renderImage();
+
+    WaterfallNode* node = static_cast<WaterfallNode*>(oldNode);
+    if(!node) {
+        // Scene graph can be invalidated, everything need to be uploaded again
+        node = new WaterfallNode;
+        for(int i = 0; i < _dirtyTiles.size(); i++) {
+            node->tileNodes.append(window()->createImageNode());
+            node->textures.append(nullptr);
+            node->appendChildNode(node->tileNodes.last());
+            _dirtyTiles[i] = true;
+        }
+        node->wrapNode = window()->createImageNode();
+        node->appendChildNode(node->wrapNode);
     }
 
-    // http://blog.qt.io/blog/2006/05/13/fast-transformed-pixmapimage-drawing/
-    pix = QPixmap::fromImage(_image, Qt::NoFormatConversion);
-    // Code for debug, draw the entire waterfall
-    //_painter->drawPixmap(_painter->viewport(), pix, QRect(0, 0, _image.width(), _image.height()));
-    _painter->drawPixmap(QRect(0, 0, width(), height()), pix,
-                         QRect(first, _minDepthToDrawInPixels, displayWidth, _maxDepthToDrawInPixels));
-}
+    // Upload only tiles with new columns
+    for(int tile = 0; tile < _dirtyTiles.size(); tile++) {
+        if(!_dirtyTiles[tile]) {
+            continue;
+        }
+        _dirtyTiles[tile] = false;
+
+        const int firstColumn = tile*tileWidth;
+        const QRect tileRect(firstColumn, 0, qMin(tileWidth, displayWidth - firstColumn), _image.height());
+        QSGTexture* texture = window()->createTextureFromImage(_image.copy(tileRect));
+        node->tileNodes[tile]->setTexture(texture);
+        if(node->wrapNode->texture() == node->textures[tile]) {
+            node->wrapNode->setTexture(texture);
+        }
+        delete node->textures[tile];
+        node->textures[tile] = texture;
+    }
 
-void Waterfall::setImage(const QImage &image)
-{
-    _image = image;
-    emit imageChanged();
-    setImplicitWidth(image.width());
-    setImplicitHeight(image.height());
-}
+    if(!node->wrapNode->texture()) {
+        node->wrapNode->setTexture(node->textures.first());
+    }
 
-QColor Waterfall::valueToRGB(float point)
-{
-    return _gradient.getColor(point);
+    /*
+        _image is used as a circular buffer of columns, the next column to be written is also the oldest one.
+        The oldest column is drawn in the left side and the newest in the right side:
+
+        0              oldestColumn                 displayWidth
+        +------------------+---------------------------+
+        |   newest part    |        oldest part        |
+        +------------------+---------------------------+
+    */
+    const int oldestColumn = displayedColumns()%displayWidth;
+    const float pixelsPerColumn = width()/displayWidth;
+    const auto filtering = antialiasing() ? QSGTexture::Linear : QSGTexture::Nearest;
+    auto displayPosition = [oldestColumn](int column) {
+        return (column - oldestColumn + displayWidth)%displayWidth;
+    };
+
+    node->wrapNode->setRect(QRectF());
+    for(int tile = 0; tile < node->tileNodes.size(); tile++) {
+        QSGImageNode* tileNode = node->tileNodes[tile];
+        const int firstColumn = tile*tileWidth;
+        const int columns = qMin(tileWidth, displayWidth - firstColumn);
+        tileNode->setFiltering(filtering);
+
+        if(oldestColumn <= firstColumn || oldestColumn >= firstColumn + columns) {
+            tileNode->setRect(displayPosition(firstColumn)*pixelsPerColumn, 0, columns*pixelsPerColumn, height());
+            tileNode->setSourceRect(0, 0, columns, _image.height());
+            continue;
+        }
+
+        // Oldest part of the tile goes to the left side, and the newest to the right side
+        const int oldestColumns = firstColumn + columns - oldestColumn;
+        tileNode->setRect(0, 0, oldestColumns*pixelsPerColumn, height());
+        tileNode->setSourceRect(oldestColumn - firstColumn, 0, oldestColumns, _image.height());
+
+        node->wrapNode->setTexture(node->textures[tile]);
+        node->wrapNode->setFiltering(filtering);
+        node->wrapNode->setRect(displayPosition(firstColumn)*pixelsPerColumn, 0,
+                                (columns - oldestColumns)*pixelsPerColumn, height());
+        node->wrapNode->setSourceRect(0, 0, columns - oldestColumns, _image.height());
+    }
+
+    return node;
 }
 
-float Waterfall::RGBToValue(const QColor& color)
+void Waterfall::renderImage()
 {
-    return _gradient.getValue(color);
+    const int renderHeight = qBound(1, qCeil(height()), maxRenderHeight);
+    const bool renderAll = _renderDirty
+                           || _image.width() != displayWidth
+                           || _image.height() != renderHeight
+                           || !qFuzzyCompare(_renderedMinDepth, _minDepthToDraw)
+                           || !qFuzzyCompare(_renderedMaxDepth, _maxDepthToDraw);
+
+    if(renderAll) {
+        if(_image.width() != displayWidth || _image.height() != renderHeight) {
+            _image = QImage(displayWidth, renderHeight, QImage::Format_ARGB32_Premultiplied);
+        }
+        _image.fill(Qt::transparent);
+        _dirtyTiles.fill(true);
+        _renderDirty = false;
+        _renderedMinDepth = _minDepthToDraw;
+        _renderedMaxDepth = _maxDepthToDraw;
+        _pendingColumns = displayWidth;
+        // Restart the smooth filter from the oldest visible column
+        _smoother.reset();
+    }
+
+    // Columns are rendered from the oldest to the newest to keep the smooth filter in order
+    for(int age = _pendingColumns - 1; age >= 0; age--) {
+        renderColumn(age);
+    }
+    _pendingColumns = 0;
 }
 
-void Waterfall::draw(const QVector<double>& points, float confidence, float initPoint, float length, float distance)
+void Waterfall::renderColumn(int age)
 {
     /*
-        initPoint: The lowest point of the last sample in meters
-        length: The length of the last sample in meters
-        _minPixelsPerMeter: waterfall max pixel height divided by max depth
-            _minPixelsPerMeter = _image.height()/_waterfallDepth;
-        lastMaxDC: Returns the last DC structure with max depth
-        lastMinDepth: Returns the minimum point in the chart
-        _minDepthToDraw: Minimum depth point, populated by lastMinDepth
-        _maxDepthToDraw: Maximum depth point, calculated from lastMaxDC
-        dynamicPixelsPerMeterScalar: Calculate the delta between number of pixels per meter
-            dynamicPixelsPerMeterScalar = 400/((_maxDepthToDraw - _minDepthToDraw)*_minPixelsPerMeter);
-
-        old (oldest sample)     new (last sample)
-        |                       |
-        +-----------------------+  - _minDepthToDrawInPixels
-        |         |-----|       |
-        |         |-----|       |
-        |         |-------------+  - virtualFloor
-        |         |-------------+  - virtualHeight
-        |         ||      |---| |
-        |         ||       |-|  |
-        |         ||       |-|  |
-        |         ||       |-|  |
-        |         +|       |-|  |
-        |         |        ++   |
-        |         |         |   |
-        |         |         |   |
-        |         |         |   |
-        |         |         |   |
-        |                   |   |
-        |                   |   |
-        |                   |   |
-        +-----------------------+  - _maxDepthToDrawInPixels = 400px
-
-        _minDepthToDrawInPixels: The lowest pixel that will appears for the user
-            _minDepthToDrawInPixels = (_minDepthToDraw*_minPixelsPerMeter*dynamicPixelsPerMeterScalar);
-        _maxDepthToDrawInPixels: Is defined to be 400 pixels
-        virtualFloor: It's the lowest pixel position to start drawing the last sample
-            virtualFloor = (initPoint*_minPixelsPerMeter*dynamicPixelsPerMeterScalar);
-        virtualFloor: It's the highest delta pixel position (from virtualFloor) to finish drawing the last sample
-            virtualHeight = ((length + initPoint - _minDepthToDraw)*_minPixelsPerMeter*dynamicPixelsPerMeterScalar);
-    */
+        Each image row represents a fixed depth in the visible window:
+            rowDepth = _renderedMinDepth + (row + 0.5)*metersPerPixel
 
-    // Declare oldImage variable to do image spins
-    static QImage old = _image;
-    // Declare oldPoints variable to do some filter
-    static QVector<double> oldPoints = points;
+        And each column has the samples of a profile between initialDepth and initialDepth + length,
+        the sample used in each row will be:
+            sample = (rowDepth - initialDepth)*columnLength/length
 
-    // This ring vector will store variables of the last n samples for user access
-    _DCRing.append({initPoint, length, confidence, distance});
+        Rows outside of the profile range are transparent.
+    */
+    const int imageColumn = (displayedColumns() - 1 - age)%displayWidth;
+    _dirtyTiles[imageColumn/tileWidth] = true;
 
-    /**
-     * @brief Get lastMaxDepth from the last n samples
-     */
-    static auto lastMaxDC = [this] {
-        float maxDepth = 0;
-        DCPack tempDC{0, 0, 0, 0};
-        for(const auto& DC : qAsConst(this->_DCRing))
-        {
-            if(maxDepth < DC.length + DC.initialDepth && DC.initialDepth != static_cast<const float>(_image.height())) {
-                maxDepth = DC.length + DC.initialDepth;
-                tempDC = DC;
-            }
-        }
-        return tempDC;
-    };
+    const int stride = _image.bytesPerLine()/sizeof(QRgb);
+    QRgb* column = reinterpret_cast<QRgb*>(_image.bits()) + imageColumn;
 
-    /**
-     * @brief Get lastMinDepth from the last n samples
-     */
-    static auto lastMinDepth = [this] {
-        float minDepth = std::numeric_limits<float>::max();
-        for(const auto& DC : qAsConst(this->_DCRing))
-        {
-            minDepth = minDepth > DC.initialDepth ? DC.initialDepth : minDepth;
+    const WaterfallHistory& level = _history.level(_historyLevel);
+    const int historyAge = age + _historyOffset;
+    if(historyAge >= level.size()) {
+        for(int row = 0; row < _image.height(); row++) {
+            column[row*stride] = 0;
         }
-        return minDepth;
-    };
+        return;
+    }
 
-    /**
-     * @brief Do a fast scale of image, but without changing the default size
-     *
-     * dst is the rectangle that will be used to draw old in `image`.
-     * src is the rectangle that will be used as source to be drawed in `image`,
-     *        the default value is old.rect().
-     *
-     */
-    static auto redrawImage = [this](const QRect& dst, QRect src = QRect()) {
-        // Use old as default rect
-        if(src.isEmpty()) {
-            src = old.rect();
-        }
+    const int columnLength = level.columnLength();
+    const uint8_t* samples = level.column(historyAge);
+    const WaterfallHistory::ColumnInfo& info = level.info(historyAge);
 
-        //Swap is faster
-        _image.swap(old);
-        _image.fill(Qt::transparent);
-        QPainter painter(&_image);
-        // Clean everything and start from zero
-        painter.fillRect(_image.rect(), Qt::transparent);
-        //QRect(0, 0, _image.width(), _image.height()*dynamicPixelsPerMeterScalar), old
-        painter.drawImage(dst, old, src);
-        painter.end();
-    };
+    if(smooth()) {
+        _columnBuffer.resize(columnLength);
+        _smoother.apply(samples, columnLength, _columnBuffer.data());
+        samples = _columnBuffer.constData();
+    }
 
-    static DCPack _maxDC;
-    _maxDC = lastMaxDC();
-    _minDepthToDraw = lastMinDepth();
-    _maxDepthToDraw = _maxDC.initialDepth + _maxDC.length;
-    emit minDepthToDrawChanged();
-    emit maxDepthToDrawChanged();
+    const float metersPerPixel = (_renderedMaxDepth - _renderedMinDepth)/_image.height();
+    if(metersPerPixel <= 0 || info.length <= 0) {
+        for(int row = 0; row < _image.height(); row++) {
+            column[row*stride] = 0;
+        }
+        return;
+    }
 
-    static bool inDynamic = false;
-    static float dynamicPixelsPerMeterScalar = 1.0;
-    // If the points/resolution is **NOT** bigger than 1pixel/point
-    if((_maxDepthToDraw - _minDepthToDraw)*_minPixelsPerMeter < 200) {
-        if(!inDynamic) {
-            inDynamic = true;
-            dynamicPixelsPerMeterScalar = 200/_minPixelsPerMeter;
+    const int firstRow = qBound(0, qCeil((info.initialDepth - _renderedMinDepth)/metersPerPixel - 0.5f),
+                                _image.height());
+    const float lastDepth = info.initialDepth + info.length;
+    const int lastRow = qBound(firstRow, qCeil((lastDepth - _renderedMinDepth)/metersPerPixel - 0.5f), _image.height());
+    const float samplesPerRow = metersPerPixel*columnLength/info.length;
+    const float firstSample = (_renderedMinDepth - info.initialDepth)*columnLength/info.length + 0.5f*samplesPerRow;
 
-            redrawImage(QRect(0, 0, _image.width(), _image.height()*dynamicPixelsPerMeterScalar));
-        }
-    } else {
-        // If the points/resolution is bigger than 1pixel/point
-        if(inDynamic) {
-            redrawImage(QRect(0, 0, _image.width(), _image.height()/dynamicPixelsPerMeterScalar));
-        }
-        inDynamic = false;
-        dynamicPixelsPerMeterScalar = 1;
+    for(int row = 0; row < firstRow; row++) {
+        column[row*stride] = 0;
     }
-    _minDepthToDrawInPixels = _minDepthToDraw*_minPixelsPerMeter;
-    _maxDepthToDrawInPixels = (_maxDepthToDraw  - _minDepthToDraw)*_minPixelsPerMeter*dynamicPixelsPerMeterScalar;
-    int virtualFloor = initPoint*_minPixelsPerMeter;
-    int virtualHeight = length*_minPixelsPerMeter*dynamicPixelsPerMeterScalar;
-
-    // Copy tail to head
-    // TODO: can we get even better and allocate just once at initialization? ie circular buffering
-    if (currentDrawIndex >= _image.width()) {
-        redrawImage(QRect(0, 0, displayWidth, _image.height()),
-                    QRect(old.width() - displayWidth, 0, displayWidth, old.height()));
-
-        // Start painting from the beginning
-        currentDrawIndex = displayWidth;
+    // Keep thin targets visible when there is more than one sample per row
+    const ColumnKernel::Mode mode = samplesPerRow > 1 ? ColumnKernel::Max : ColumnKernel::Linear;
+    _rowBuffer.resize(_image.height());
+    ColumnKernel::resample(samples, columnLength, firstSample + firstRow*samplesPerRow, samplesPerRow,
+                           _rowBuffer.data(), lastRow - firstRow, mode);
+    // Colors are opaque, so there is no difference between premultiplied and straight alpha
+    ColumnKernel::colorize(_rowBuffer.constData(), lastRow - firstRow, _gradient.colorTable().constData(),
+                           column + firstRow*stride, stride);
+    for(int row = lastRow; row < _image.height(); row++) {
+        column[row*stride] = 0;
     }
+}
 
-    // Do up/downsampling
-    float factor = points.length()/((float)(virtualHeight));
+QColor Waterfall::valueToRGB(float point)
+{
+    return _gradient.getColor(point);
+}
+
+float Waterfall::RGBToValue(const QColor& color)
+{
+    return _gradient.getValue(color);
+}
+
+void Waterfall::appendProfile(const Profile::Pointer& profile)
+{
+    /*
+        initPoint: The lowest point of the last sample in meters
+        length: The length of the last sample in meters
+        _minDepthToDraw: Minimum depth point of the last n samples
+        _maxDepthToDraw: Maximum depth point of the last n samples
+
+        The profile is stored as raw intensity in _history, colors are applied when rendering.
+    */
 
-    // Check if everything is correct before the draw
-    if(floor(factor*virtualHeight) > points.length() || factor*virtualHeight < 0) {
-        qCWarning(waterfall) << "Wrong factor !";
-        qCDebug(waterfall).noquote() << QStringLiteral("virtualHeight: %1\t virtualFloor: %2\t factor: %3\t").
-                                     arg(virtualHeight).arg(virtualFloor).arg(factor);
+    const float initPoint = profile->initialDepth();
+    const float length = profile->length();
+    if(!profile->size() || length <= 0 || initPoint < 0 || initPoint + length > _waterfallDepth) {
+        qCWarning(waterfall) << "Invalid profile !";
+        qCDebug(waterfall).noquote() << QStringLiteral("points: %1\t initPoint: %2\t length: %3")
+                                     .arg(profile->size()).arg(initPoint).arg(length);
         return;
     }
 
-    if(virtualFloor + virtualHeight > _image.height()
-            || virtualFloor + virtualHeight < 0
-            || virtualFloor < 0) {
-        qCWarning(waterfall) << "Wrong Floor Height";
-        qCDebug(waterfall).noquote() <<
-                                     QStringLiteral("virtualFloor: %1\t virtualHeight: %2\t _minDepthToDrawInPixels: %3\t _maxDepthToDrawInPixels: %4")
-                                     .arg(virtualFloor).arg(virtualHeight).arg(_minDepthToDrawInPixels).arg(_maxDepthToDrawInPixels);
-        qCDebug(waterfall).noquote() <<
-                                     QStringLiteral("initPoint: %1\t length: %2\t _minPixelsPerMeter: %3\t dynamicPixelsPerMeterScalar: %4")
-                                     .arg(initPoint).arg(length).arg(_minPixelsPerMeter).arg(dynamicPixelsPerMeterScalar);
+    // Only the shared pointer is kept, the profile is converted when added to the history
+    _pendingProfiles.append(profile);
+
+    // Profiles are added to the history in the next frame, there is no frame without a window
+    // A window that is not rendered (minimized or not exposed) does not polish, so a full image is added right away
+    if(window() && _pendingProfiles.size() < displayWidth) {
+        polish();
+    } else {
+        updatePolish();
+    }
+}
+
+void Waterfall::updatePolish()
+{
+    if(_pendingProfiles.isEmpty()) {
         return;
     }
 
-    if(smooth()) {
-        #pragma omp for
-        for(int i = 0; i < points.length(); i++) {
-            oldPoints[i] = points[i]*0.2 + oldPoints[i]*0.8;
-        }
+    const uint32_t levelCount = _history.count(_historyLevel);
+    for(const auto& profile : qAsConst(_pendingProfiles)) {
+        // Raw samples are stored as they are, colors are applied when rendering
+        const WaterfallHistory::ColumnInfo info{profile->initialDepth(), profile->length()};
+        _history.append(profile->data(), profile->size(), info);
 
-        #pragma omp for
-        for(int i = 0; i < virtualHeight; i++) {
-            _image.setPixelColor(currentDrawIndex, i + virtualFloor, valueToRGB(oldPoints[factor*i]));
-        }
-    } else {
-        #pragma omp for
-        for(int i = 0; i < virtualHeight; i++) {
-            _image.setPixelColor(currentDrawIndex, i + virtualFloor, valueToRGB(points[factor*i]));
+        // This ring vector will store variables of the last n samples for user access
+        _DCRing.append({profile->initialDepth(), profile->length(), profile->confidence(), profile->distance()});
+        _minDepthWindow.append(profile->initialDepth());
+        _maxDepthWindow.append(profile->initialDepth() + profile->length());
+    }
+    _pendingProfiles.clear();
+    emit historySizeChanged();
+
+    // Only the displayed level matters for the image
+    const int newColumns = _history.count(_historyLevel) - levelCount;
+    if(newColumns > 0) {
+        if(_historyOffset > 0) {
+            // Keep the old columns being reviewed in place, the image only changes when the oldest columns are dropped
+            const int offset = _historyOffset + newColumns;
+            _historyOffset = qMin(offset, historySize() - 1);
+            _renderDirty = _renderDirty || _historyOffset != offset;
+            emit historyOffsetChanged();
+        } else {
+            _pendingColumns = qMin<int>(_pendingColumns + newColumns, displayWidth);
+            updateDepthWindow();
         }
     }
-    currentDrawIndex++; // This can get to be an issue at very fast update rates from ping
 
-    // Fix max update in 20Hz at max
-    if(!_updateTimer->isActive()) {
-        _updateTimer->start(50);
-    }
+    update();
 }
 
 void Waterfall::hoverMoveEvent(QHoverEvent *event)
@@ -380,24 +521,25 @@ void Waterfall::hoverMoveEvent(QHoverEvent *event)
     _mousePos = pos;
     emit mousePosChanged();
 
-    static uint16_t first;
-    if (currentDrawIndex < displayWidth) {
-        first = 0;
-    } else {
-        first = currentDrawIndex - displayWidth;
-    }
-
-    int widthPos = pos.x()*displayWidth/width();
-    pos.setX(pos.x()*displayWidth/width() + first);
-    pos.setY(pos.y()*(_maxDepthToDrawInPixels-_minDepthToDrawInPixels)/(float)height());
-
     // depth
-    _mouseDepth = pos.y()/(float)_minPixelsPerMeter;
+    _mouseDepth = _minDepthToDraw + pos.y()*(_maxDepthToDraw - _minDepthToDraw)/height();
     emit mouseMove();
 
-    const auto& depthAndConfidence = _DCRing[displayWidth - widthPos];
-    _mouseColumnConfidence = depthAndConfidence.confidence;
-    _mouseColumnDepth = depthAndConfidence.distance;
+    // The newest column is in the right side
+    const int age = qBound(0, displayWidth - 1 - static_cast<int>(pos.x()*displayWidth/width()), displayWidth - 1);
+    const int value = _history.level(_historyLevel).value(age + _historyOffset, _mouseDepth);
+    _mouseValue = value < 0 ? -1 : value/255.0f;
+    emit mouseValueChanged();
+
+    // Confidence and distance are only available for the last received profiles
+    if(isLive()) {
+        const auto& depthAndConfidence = _DCRing[age];
+        _mouseColumnConfidence = depthAndConfidence.confidence;
+        _mouseColumnDepth = depthAndConfidence.distance;
+    } else {
+        _mouseColumnConfidence = 0;
+        _mouseColumnDepth = 0;
+    }
     emit mouseColumnConfidenceChanged();
     emit mouseColumnDepthChanged();
 }
@@ -407,6 +549,7 @@ void Waterfall::hoverLeaveEvent(QHoverEvent *event)
     Q_UNUSED(event)
     // The mouse is not inside the waterfall area, so set the depth under the mouse to an invalid value
     _mouseDepth = -1;
+    _mouseValue = -1;
     _containsMouse = false;
     emit containsMouseChanged();
 }
@@ -1,9 +1,12 @@
-#include <QQuickPaintedItem>
 #include <QImage>
+#include <QQuickItem>
 
 #include "logger.h"
+#include "columnsmoother.h"
+#include "profilesink.h"
 #include "ringvector.h"
 #include "waterfallgradient.h"
+#include "waterfallpyramid.h"
 
 Q_DECLARE_LOGGING_CATEGORY(waterfall)
 
@@ -11,9 +14,10 @@ Q_DECLARE_LOGGING_CATEGORY(waterfall)
  * @brief Waterfall widget
  *
  */
-class Waterfall : public QQuickPaintedItem
+class Waterfall : public QQuickItem, public ProfileSink
 {
     Q_OBJECT
+    Q_INTERFACES(ProfileSink)
 public:
     /**
      * @brief Clear waterfall and restart all parameters
@@ -22,20 +26,21 @@ public:
     Q_INVOKABLE void clear();
 
     /**
-     * @brief Return waterfall image
+     * @brief Get depth from mouse position
      *
-     * @return QImage
+     * @return float
      */
-    QImage image() {return _image;}
-    Q_PROPERTY(QImage image READ image WRITE setImage NOTIFY imageChanged)
+    float mouseDepth() {return _mouseDepth;}
+    Q_PROPERTY(float mouseDepth READ mouseDepth NOTIFY mouseDepthChanged)
 
     /**
-     * @brief Get depth from mouse position
+     * @brief Get the raw signal value (0-1) from mouse position
+     *  The value is -1 if there is no signal information in the mouse position
      *
      * @return float
      */
-    float mouseDepth() {return _mouseDepth;}
-    Q_PROPERTY(float mouseDepth READ mouseDepth NOTIFY mouseDepthChanged)
+    float mouseValue() {return _mouseValue;}
+    Q_PROPERTY(float mouseValue READ mouseValue NOTIFY mouseValueChanged)
 
     /**
      * @brief Get signal confidence from mouse position column
@@ -99,15 +104,85 @@ public:
      *
      * @param smooth
      */
-    void setSmooth(bool smooth) {_smooth = smooth; emit smoothChanged();}
+    void setSmooth(bool smooth) {_smooth = smooth; _renderDirty = true; update(); emit smoothChanged();}
     Q_PROPERTY(bool smooth READ smooth WRITE setSmooth NOTIFY smoothChanged)
 
+    /**
+     * @brief Return the weight of the new profile in the smooth filter
+     *
+     * @return float
+     */
+    float smoothFactor() {return _smoother.alpha();}
+
+    /**
+     * @brief Set the weight of the new profile in the smooth filter
+     *
+     * @param factor between 0 and 1
+     */
+    void setSmoothFactor(float factor);
+    Q_PROPERTY(float smoothFactor READ smoothFactor WRITE setSmoothFactor NOTIFY smoothFactorChanged)
+
+    /**
+     * @brief Return the history level being displayed
+     *  Each column of the level N represents 4^N profiles
+     *
+     * @return int
+     */
+    int historyLevel() {return _historyLevel;}
+
+    /**
+     * @brief Set the history level being displayed, used to zoom out over long sessions
+     *
+     * @param level between 0 and historyLevels - 1
+     */
+    void setHistoryLevel(int level);
+    Q_PROPERTY(int historyLevel READ historyLevel WRITE setHistoryLevel NOTIFY historyLevelChanged)
+
+    /**
+     * @brief Return the number of history levels
+     *
+     * @return int
+     */
+    int historyLevels() {return WaterfallPyramid::levels;}
+    Q_PROPERTY(int historyLevels READ historyLevels CONSTANT)
+
+    /**
+     * @brief Return the number of profiles represented by each column of the displayed level
+     *
+     * @return int
+     */
+    int historyDecimation() {return WaterfallPyramid::decimation(_historyLevel);}
+    Q_PROPERTY(int historyDecimation READ historyDecimation NOTIFY historyLevelChanged)
+
+    /**
+     * @brief Return the number of columns available in the displayed level
+     *
+     * @return int
+     */
+    int historySize() {return _history.level(_historyLevel).size();}
+    Q_PROPERTY(int historySize READ historySize NOTIFY historySizeChanged)
+
+    /**
+     * @brief Return the age of the newest displayed column, in columns of the displayed level
+     *
+     * @return int
+     */
+    int historyOffset() {return _historyOffset;}
+
+    /**
+     * @brief Set the age of the newest displayed column, 0 shows the last received profiles
+     *
+     * @param offset in columns of the displayed level
+     */
+    void setHistoryOffset(int offset);
+    Q_PROPERTY(int historyOffset READ historyOffset WRITE setHistoryOffset NOTIFY historyOffsetChanged)
+
     /**
      * @brief Set antialiasing proprieties
      *
      * @param antialiasing
      */
-    void setAliasing(bool antialiasing) {setAntialiasing(antialiasing); emit antialiasingChanged();}
+    void setAliasing(bool antialiasing) {setAntialiasing(antialiasing); update(); emit antialiasingChanged();}
     Q_PROPERTY(bool antialiasing READ antialiasing WRITE setAliasing NOTIFY antialiasingChanged)
 
     /**
@@ -126,26 +201,45 @@ public:
 
     QVector<WaterfallGradient> _gradients;
     WaterfallGradient _gradient;
+    WaterfallPyramid _history;
+    int _historyLevel;
+    int _historyOffset;
     QImage _image;
-    QPainter *_painter;
-    float _minPixelsPerMeter;
     float _maxDepthToDraw;
-    float _maxDepthToDrawInPixels;
     float _minDepthToDraw;
-    float _minDepthToDrawInPixels;
     float _mouseColumnConfidence;
     float _mouseColumnDepth;
     float _mouseDepth;
+    float _mouseValue;
     bool _containsMouse;
     QPoint _mousePos;
     bool _smooth;
-    QTimer* _updateTimer;
     QString _theme;
     QStringList _themes;
     static uint16_t displayWidth;
-    uint16_t currentDrawIndex;
     float _waterfallDepth;
 
+    /**
+     * @brief Render state of _image
+     *  _image is a circular buffer of displayWidth columns, where each column is a rendered profile
+     */
+    ///@{
+    // Number of new columns of the displayed level that are not rendered
+    int _pendingColumns;
+    // Everything should be rendered again, E.g: theme, smooth or history changed
+    bool _renderDirty;
+    float _renderedMaxDepth;
+    float _renderedMinDepth;
+    // Tiles of _image that changed since the last scene graph update
+    QVector<bool> _dirtyTiles;
+    ///@}
+
+    // Column after the filters, ready to be colorized
+    QVector<uint8_t> _columnBuffer;
+    // Column resampled to the image rows
+    QVector<uint8_t> _rowBuffer;
+    ColumnSmoother _smoother;
+
     /**
      * @brief Depth and Confidence package
      *
@@ -159,12 +253,18 @@ public:
 
     RingVector<DCPack> _DCRing;
 
+    // Profiles waiting for the next frame
+    QVector<Profile::Pointer> _pendingProfiles;
+    // Depth range of the last displayWidth profiles
+    RingWindowExtreme<float> _minDepthWindow;
+    RingWindowExtreme<float, std::greater<float>> _maxDepthWindow;
+
 signals:
     void antialiasingChanged();
-    void imageChanged();
     void minDepthToDrawChanged();
     void maxDepthToDrawChanged();
     void mouseDepthChanged();
+    void mouseValueChanged();
     void mouseColumnConfidenceChanged();
     void mouseColumnDepthChanged();
     // TODO: mouseMove should be renamed
@@ -174,6 +274,10 @@ signals:
     void themeChanged();
     void themesChanged();
     void smoothChanged();
+    void smoothFactorChanged();
+    void historyLevelChanged();
+    void historySizeChanged();
+    void historyOffsetChanged();
 
 public:
     /**
@@ -184,19 +288,22 @@ public:
     Waterfall(QQuickItem *parent = nullptr);
 
     /**
-     * @brief This is used by the qml pain event
-     *  This paint the waterfall in qml
+     * @brief Update the scene graph node of the waterfall
+     *  Colors are applied only over the visible window, and only the tiles with new columns are uploaded.
+     *  This runs in the render thread while the GUI thread is blocked.
      *
-     * @param painer
+     * @param oldNode
+     * @param updatePaintNodeData
+     * @return QSGNode*
      */
-    void paint(QPainter *painer);
+    QSGNode* updatePaintNode(QSGNode* oldNode, UpdatePaintNodeData* updatePaintNodeData) override;
 
     /**
-     * @brief Set the waterfall Image
+     * @brief Add all profiles received since the last frame to the history
+     *  This runs once per frame in the GUI thread, before the scene graph is synchronized.
      *
-     * @param image
      */
-    void setImage(const QImage &image);
+    void updatePolish() override;
 
     /**
      * @brief Set all gradients used for the themes
@@ -206,6 +313,7 @@ public:
 
     /**
      * @brief Set the waterfall max depth in meters
+     *  Profiles deeper than that will be ignored
      *
      * @param maxDepth
      */
@@ -220,6 +328,7 @@ public:
 
     /**
      * @brief Transform a power value 0-1 to color
+     *  Check WaterfallGradient::getRgb for the fast lookup table version
      *
      * @param point
      * @return QColor
@@ -228,6 +337,7 @@ public:
 
     /**
      * @brief Transform color to a power value
+     *  This is an approximation, check WaterfallHistory::value for the raw value
      *
      * @param color
      * @return float
@@ -235,16 +345,18 @@ public:
     float RGBToValue(const QColor& color);
 
     /**
-     * @brief Draw a list of points in the waterfall
+     * @brief Queue a profile to be drawn in the next frame
+     *  All profiles queued between two frames are added to the history at once
+     *
+     * @param profile
+     */
+    void appendProfile(const Profile::Pointer& profile) override;
+
+    /**
+     * @brief Clear the history, the next profiles rebuild it
      *
-     * @param points
-     * @param confidence
-     * @param initPoint
-     * @param length
-     * @param distance
      */
-    Q_INVOKABLE void draw(const QVector<double>& points, float confidence = 0, float initPoint = 0, float length = 50,
-                          float distance = 0);
+    void clearProfiles() override { clear(); };
 
     /**
      * @brief Function that deals when the mouse is inside the waterfall
@@ -274,4 +386,40 @@ private:
      *
      */
     void loadUserGradients();
+
+    /**
+     * @brief Colorize pending columns of the visible window in _image
+     *  Everything will be rendered again if the depth window, the item height or the render state changed
+     *
+     */
+    void renderImage();
+
+    /**
+     * @brief Colorize a single column from the history in _image
+     *
+     * @param age 0 is the newest displayed column
+     */
+    void renderColumn(int age);
+
+    /**
+     * @brief Update the depth window with the visible columns
+     *
+     */
+    void updateDepthWindow();
+
+    /**
+     * @brief Check if the last received profiles are being displayed
+     *
+     * @return true
+     * @return false
+     */
+    bool isLive() const {return _historyLevel == 0 && _historyOffset == 0;}
+
+    /**
+     * @brief Return the number of columns of the displayed level up to the newest displayed column
+     *  Used to find the column position in _image, it does not change while old columns are being reviewed
+     *
+     * @return uint32_t
+     */
+    uint32_t displayedColumns() const {return _history.count(_historyLevel) - _historyOffset;}
 };
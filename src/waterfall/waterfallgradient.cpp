@@ -80,6 +80,21 @@ void WaterfallGradient::setColors(const QVector<QColor>& colors)
     for(int i = 0; i < colors.size(); i++) {
         setColorAt(i/numberOfColors, colors[i]);
     }
+    compileColorTable();
+}
+
+void WaterfallGradient::compileColorTable()
+{
+    // Invalid gradients will have a black color table
+    if(stops().length() < 2) {
+        _colorTable.fill(qRgb(0, 0, 0));
+        return;
+    }
+
+    const float lastIndex = _colorTable.size() - 1;
+    for(int i = 0; i < _colorTable.size(); i++) {
+        _colorTable[i] = getColor(i/lastIndex).rgb();
+    }
 }
 
 void WaterfallGradient::setName(const QString& name)
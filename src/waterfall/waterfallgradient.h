@@ -13,6 +13,7 @@ class WaterfallGradient : public QLinearGradient
 {
     QString _name;
     bool _isOk = false;
+    QVector<QRgb> _colorTable = QVector<QRgb>(256, qRgb(0, 0, 0));
 public:
     /**
      * @brief Construct a new Waterfall Gradient object
@@ -66,6 +67,22 @@ public:
      */
     QColor getColor(float value) const;
 
+    /**
+     * @brief Get color from the compiled color table using a raw 0-255 value
+     *  This avoids the stops interpolation and is the one that should be used in hot loops
+     *
+     * @param value
+     * @return QRgb
+     */
+    QRgb getRgb(uint8_t value) const { return _colorTable[value]; };
+
+    /**
+     * @brief Return the compiled color table, with one entry for each 0-255 value
+     *
+     * @return const QVector<QRgb>&
+     */
+    const QVector<QRgb>& colorTable() const { return _colorTable; };
+
     /**
      * @brief Get value from color 0-0-0 to 255-255-255
      *
@@ -106,4 +123,12 @@ public:
      * @return float
      */
     float valueLinearInterpolation(const QColor& color, const QGradientStop& color1, const QGradientStop& color2) const;
+
+private:
+    /**
+     * @brief Populate the color table using the gradient stops
+     *  This should be called every time that the gradient colors change
+     *
+     */
+    void compileColorTable();
 };
\ No newline at end of file
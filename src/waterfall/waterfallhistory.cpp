@@ -0,0 +1,56 @@
+#include <cstring>
+
+#include "columnkernel.h"
+#include "waterfallhistory.h"
+
+WaterfallHistory::WaterfallHistory(int capacity, int columnLength)
+    : _capacity(capacity)
+    , _columnLength(columnLength)
+    , _head(0)
+    , _size(0)
+    , _infos(capacity, {0, 0})
+    , _samples(capacity*columnLength, 0)
+{
+}
+
+void WaterfallHistory::append(const uint8_t* samples, int length, const ColumnInfo& info)
+{
+    if(!samples || length <= 0) {
+        return;
+    }
+
+    uint8_t* column = _samples.data() + _head*_columnLength;
+    if(length == _columnLength) {
+        memcpy(column, samples, _columnLength);
+    } else {
+        // Longer profiles keep the max value of each group of samples to not lose thin targets
+        const float samplesPerRow = length/float(_columnLength);
+        ColumnKernel::resample(samples, length, samplesPerRow/2, samplesPerRow, column, _columnLength,
+                               samplesPerRow > 1 ? ColumnKernel::Max : ColumnKernel::Linear);
+    }
+    _infos[_head] = info;
+
+    _head = (_head + 1)%_capacity;
+    _size = qMin(_size + 1, _capacity);
+}
+
+void WaterfallHistory::clear()
+{
+    _head = 0;
+    _size = 0;
+}
+
+int WaterfallHistory::value(int age, float depth) const
+{
+    if(age < 0 || age >= _size) {
+        return -1;
+    }
+
+    const ColumnInfo& columnInfo = info(age);
+    const float position = (depth - columnInfo.initialDepth)/columnInfo.length;
+    if(columnInfo.length <= 0 || position < 0 || position >= 1) {
+        return -1;
+    }
+
+    return column(age)[static_cast<int>(position*_columnLength)];
+}
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <QVector>
+
+/**
+ * @brief Column-major circular history of raw profiles
+ *  Each column keeps the raw profile intensity (0-255) with a fixed number of samples and the depth range
+ *  that it covers. Colors are only applied when the waterfall is rendered.
+ *
+ */
+class WaterfallHistory
+{
+public:
+    /**
+     * @brief Depth range covered by a column in meters
+     *
+     */
+    struct ColumnInfo {
+        float initialDepth;
+        float length;
+    };
+
+    /**
+     * @brief Construct a new Waterfall History object
+     *
+     * @param capacity number of columns
+     * @param columnLength number of samples in each column
+     */
+    WaterfallHistory(int capacity = 2048, int columnLength = 200);
+
+    /**
+     * @brief Append a new profile, the oldest column will be overwritten when the history is full
+     *  Profiles with a different length will be resampled to columnLength, the buffer is not reallocated
+     *
+     * @param samples
+     * @param length
+     * @param info
+     */
+    void append(const uint8_t* samples, int length, const ColumnInfo& info);
+
+    /**
+     * @brief Remove all columns
+     *
+     */
+    void clear();
+
+    /**
+     * @brief Return column samples
+     *
+     * @param age 0 is the newest column
+     * @return const uint8_t* with columnLength samples
+     */
+    const uint8_t* column(int age) const { return _samples.constData() + index(age)*_columnLength; };
+
+    /**
+     * @brief Return column depth information
+     *
+     * @param age 0 is the newest column
+     * @return const ColumnInfo&
+     */
+    const ColumnInfo& info(int age) const { return _infos[index(age)]; };
+
+    /**
+     * @brief Return the raw value of a column in a specific depth
+     *
+     * @param age 0 is the newest column
+     * @param depth in meters
+     * @return int 0-255 value or -1 if the depth is not covered by the column
+     */
+    int value(int age, float depth) const;
+
+    /**
+     * @brief Return number of columns that can be stored
+     *
+     * @return int
+     */
+    int capacity() const { return _capacity; };
+
+    /**
+     * @brief Return number of samples of each column
+     *
+     * @return int
+     */
+    int columnLength() const { return _columnLength; };
+
+    /**
+     * @brief Return number of valid columns
+     *
+     * @return int
+     */
+    int size() const { return _size; };
+
+private:
+    int index(int age) const { return (_head - 1 - age + _capacity)%_capacity; };
+
+    int _capacity;
+    int _columnLength;
+    // Next column to be written
+    int _head;
+    int _size;
+    QVector<ColumnInfo> _infos;
+    QVector<uint8_t> _samples;
+};
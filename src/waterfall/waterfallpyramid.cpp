@@ -0,0 +1,86 @@
+#include <cstring>
+
+#include "waterfallpyramid.h"
+
+WaterfallPyramid::WaterfallPyramid(int capacity, int columnLength)
+    : _counts(levels, 0)
+    , _decimated(columnLength, 0)
+{
+    for(int i = 0; i < levels; i++) {
+        _levels.append(WaterfallHistory(capacity, columnLength));
+    }
+}
+
+void WaterfallPyramid::append(const uint8_t* samples, int length, const WaterfallHistory::ColumnInfo& info)
+{
+    if(!samples || length <= 0) {
+        return;
+    }
+
+    _levels[0].append(samples, length, info);
+    _counts[0]++;
+
+    // Each complete group of a level creates a column in the next one
+    for(int level = 0; level + 1 < levels && _counts[level]%groupSize == 0; level++) {
+        decimate(level);
+    }
+}
+
+void WaterfallPyramid::clear()
+{
+    for(int i = 0; i < levels; i++) {
+        _levels[i].clear();
+        _counts[i] = 0;
+    }
+}
+
+void WaterfallPyramid::decimate(int level)
+{
+    const WaterfallHistory& source = _levels[level];
+    const int columnLength = source.columnLength();
+
+    // The merged column covers the depth range of all columns in the group
+    bool sameRange = true;
+    float initialDepth = source.info(0).initialDepth;
+    float finalDepth = initialDepth + source.info(0).length;
+    for(int age = 1; age < groupSize; age++) {
+        const WaterfallHistory::ColumnInfo& info = source.info(age);
+        sameRange = sameRange && info.initialDepth == source.info(0).initialDepth
+                    && info.length == source.info(0).length;
+        initialDepth = qMin(initialDepth, info.initialDepth);
+        finalDepth = qMax(finalDepth, info.initialDepth + info.length);
+    }
+    const float length = finalDepth - initialDepth;
+
+    uint8_t* decimated = _decimated.data();
+    if(sameRange) {
+        memcpy(decimated, source.column(0), columnLength);
+        for(int age = 1; age < groupSize; age++) {
+            const uint8_t* column = source.column(age);
+            for(int i = 0; i < columnLength; i++) {
+                decimated[i] = qMax(decimated[i], column[i]);
+            }
+        }
+    } else {
+        memset(decimated, 0, columnLength);
+        for(int age = 0; age < groupSize; age++) {
+            const WaterfallHistory::ColumnInfo& info = source.info(age);
+            if(info.length <= 0) {
+                continue;
+            }
+            const uint8_t* column = source.column(age);
+            // Position of each merged sample center in the samples of this column
+            const float scale = length/info.length;
+            const float offset = (initialDepth - info.initialDepth)*columnLength/info.length;
+            for(int i = 0; i < columnLength; i++) {
+                const float sample = offset + (i + 0.5f)*scale;
+                if(sample >= 0 && sample < columnLength) {
+                    decimated[i] = qMax(decimated[i], column[static_cast<int>(sample)]);
+                }
+            }
+        }
+    }
+
+    _levels[level + 1].append(decimated, columnLength, {initialDepth, length});
+    _counts[level + 1]++;
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <QVector>
+
+#include "waterfallhistory.h"
+
+/**
+ * @brief Multi-resolution waterfall history
+ *  Level 0 keeps the raw columns and each following level keeps one column for every 4 columns of the previous
+ *  level (1x, 4x, 16x and 64x). Decimated columns use the max of the original columns, so targets are not lost
+ *  when zooming out.
+ *
+ *  All levels have the same capacity, so the memory is bounded to levels*capacity*columnLength bytes.
+ *  With the default values (~10MB) the last level covers 64*12288 columns, more than 10 hours at 20Hz.
+ *
+ */
+class WaterfallPyramid
+{
+public:
+    /**
+     * @brief Construct a new Waterfall Pyramid object
+     *
+     * @param capacity number of columns of each level
+     * @param columnLength number of samples in each column
+     */
+    WaterfallPyramid(int capacity = 12288, int columnLength = 200);
+
+    /**
+     * @brief Append a new profile to the first level, the next levels are updated when a group is complete
+     *
+     * @param samples
+     * @param length
+     * @param info
+     */
+    void append(const uint8_t* samples, int length, const WaterfallHistory::ColumnInfo& info);
+
+    /**
+     * @brief Remove all columns of all levels
+     *
+     */
+    void clear();
+
+    /**
+     * @brief Return a history level
+     *
+     * @param level 0 is the raw history
+     * @return const WaterfallHistory&
+     */
+    const WaterfallHistory& level(int level) const { return _levels[level]; };
+
+    /**
+     * @brief Return the total number of columns appended to a level since the last clear
+     *
+     * @param level
+     * @return uint32_t
+     */
+    uint32_t count(int level) const { return _counts[level]; };
+
+    /**
+     * @brief Return number of raw columns represented by a column of a level
+     *
+     * @param level
+     * @return int
+     */
+    static int decimation(int level) { return 1 << (2*level); };
+
+    /**
+     * @brief Number of columns merged in each decimated column
+     *
+     */
+    static const int groupSize = 4;
+
+    /**
+     * @brief Number of levels
+     *
+     */
+    static const int levels = 4;
+
+private:
+    /**
+     * @brief Merge the last group of a level into a column of the next level
+     *
+     * @param level
+     */
+    void decimate(int level);
+
+    QVector<uint32_t> _counts;
+    QVector<WaterfallHistory> _levels;
+    // Merged column
+    QVector<uint8_t> _decimated;
+};